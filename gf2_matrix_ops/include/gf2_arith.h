@@ -0,0 +1,56 @@
+#ifndef GF2_ARITH_H
+#define GF2_ARITH_H
+
+#include "gf2_matrix.h"
+
+/*
+ * Arithmetic on packed GF2_MATRIX values. Vectors are 1 x n matrices (row vectors). Dimensions
+ * must agree as stated for each function; functions that create a matrix return NULL if it could
+ * not be allocated.
+ */
+
+/**
+ * Adds two matrices of the same dimensions. Over GF(2) addition is an XOR of the packed words.
+ * @param[in] a a matrix.
+ * @param[in] b a matrix with the dimensions of a.
+ * @return a + b.
+ */
+GF2_MATRIX GF2_add(const GF2_MATRIX a, const GF2_MATRIX b);
+
+/**
+ * Adds a matrix into another: dst = dst + src.
+ * @param[in] dst the matrix that is updated.
+ * @param[in] src a matrix with the dimensions of dst.
+ */
+void GF2_addTo(GF2_MATRIX dst, const GF2_MATRIX src);
+
+/**
+ * Multiplies a matrix by a column vector, given as a row vector.
+ * @param[in] a an M x N matrix.
+ * @param[in] x a 1 x N vector.
+ * @return the 1 x M vector (a * x^T)^T.
+ */
+GF2_MATRIX GF2_mulVec(const GF2_MATRIX a, const GF2_MATRIX x);
+
+/**
+ * Multiplies two matrices.
+ * @param[in] a an M x K matrix.
+ * @param[in] b a K x N matrix.
+ * @return the M x N matrix a * b.
+ */
+GF2_MATRIX GF2_multiply(const GF2_MATRIX a, const GF2_MATRIX b);
+
+/**
+ * @param[in] m an M x N matrix.
+ * @return the N x M transpose of m.
+ */
+GF2_MATRIX GF2_transpose(const GF2_MATRIX m);
+
+/**
+ * Computes the rank by Gaussian elimination on a copy of the matrix.
+ * @param[in] m the matrix.
+ * @return the rank of m, or SIZE_MAX if the copy could not be allocated.
+ */
+size_t GF2_rank(const GF2_MATRIX m);
+
+#endif // GF2_ARITH_H
@@ -0,0 +1,56 @@
+#ifndef GF2_M4R_H
+#define GF2_M4R_H
+
+#include "gf2_matrix.h"
+
+/*
+ * "Method of Four Russians" algorithms for large dense matrices. Both precompute, for a group of
+ * k rows, all 2^k sums of those rows in Gray-code order (one row XOR per entry), and then replace
+ * up to k row additions with a single table lookup. With k = 8 and 8 tables per 64-bit word of
+ * the left operand, one pass over a row adds up to 64 rows of the right operand with 8 XORs.
+ */
+
+// Multiplications whose dimensions are all above this size are split by Strassen-Winograd
+// recursion; smaller ones are computed directly with M4RM. Tuned with gf2_matrix_bench.
+#ifndef GF2_STRASSEN_CUTOFF
+#define GF2_STRASSEN_CUTOFF 4096
+#endif
+
+/**
+ * Multiplies two matrices with the Method of Four Russians (M4RM), O(n^3 / log n).
+ * @param[in] a an M x K matrix.
+ * @param[in] b a K x N matrix.
+ * @return the M x N matrix a * b, or NULL if it could not be allocated.
+ */
+GF2_MATRIX GF2_multiplyM4RM(const GF2_MATRIX a, const GF2_MATRIX b);
+
+/**
+ * Multiplies two matrices with Strassen-Winograd recursion (7 half-size products instead of 8,
+ * O(n^2.81)) down to GF2_STRASSEN_CUTOFF, and M4RM below it.
+ * @param[in] a an M x K matrix.
+ * @param[in] b a K x N matrix.
+ * @return the M x N matrix a * b, or NULL if it could not be allocated.
+ */
+GF2_MATRIX GF2_multiplyStrassen(const GF2_MATRIX a, const GF2_MATRIX b);
+
+/**
+ * Reduces a matrix in place to reduced row echelon form with the Method of Four Russians (M4RI).
+ * Columns are taken 64 at a time: the pivots among them are found and reduced against each other,
+ * and then all 64 columns are cleared from every other row with 8 table lookups per row.
+ * @param[in] m the matrix.
+ * @param[in] pivotCols only the first pivotCols columns are used as pivots, e.g. the coefficient
+ * part of an augmented matrix; at most m->cols.
+ * @param[out] pivots receives the pivot column (counting from 1) of each of the first 'rank'
+ * rows; may be NULL.
+ * @return the rank, or SIZE_MAX if memory ran out.
+ */
+size_t GF2_reduceM4RI(GF2_MATRIX m, const size_t pivotCols, size_t *pivots);
+
+/**
+ * Inverts a square matrix by Gauss-Jordan elimination with the Method of Four Russians (M4RI).
+ * @param[in] m a square matrix.
+ * @return the inverse of m, or NULL if m is singular or memory ran out.
+ */
+GF2_MATRIX GF2_invertM4RI(const GF2_MATRIX m);
+
+#endif // GF2_M4R_H
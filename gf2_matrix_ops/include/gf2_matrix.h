@@ -1,27 +1,42 @@
+#ifndef GF2_MATRIX_H
+#define GF2_MATRIX_H
+
 #include <stddef.h>
 #include <stdint.h>
 
+typedef uint64_t GF2_WORD;
+
+#define GF2_WORD_BITS 64                                  // Elements packed into a GF2_WORD.
+#define GF2_ALIGNMENT 64                                  // Rows start on cache-line boundaries.
+#define GF2_STRIDE_ALIGN (GF2_ALIGNMENT / sizeof(GF2_WORD)) // Row strides are multiples of this.
+
+/**
+ * Elements are packed 64 to a word in row-major order: column c of a row (counting from 0) is bit
+ * (c % 64) of word (c / 64). Each row is padded to 'stride' words so that every row starts on its
+ * own cache line, and the padding bits are always zero.
+ */
 typedef struct _matrix {
     size_t rows;         // Rows in the Matrix
     size_t cols;         // Columns in the Matrix
-    uint8_t *m;         // Pointer to Matrix Array.
+    size_t stride;       // Words per row, a multiple of GF2_STRIDE_ALIGN
+    GF2_WORD *m;         // Pointer to the rows*stride words of the Matrix, GF2_ALIGNMENT aligned.
 } Matrix;
 
 typedef uint8_t GF2_ELEM;
 typedef Matrix* GF2_MATRIX;
 
 /**
- * Creates a 'row by col' matrix of any size.
+ * Creates a 'row by col' matrix of any size with every element set to 0.
  * @param[in] rows the number of rows in the matrix.
  * @param[in] cols the number of columns in the matrix.
- * @return a GF2_MATRIX pointer.
+ * @return a GF2_MATRIX pointer, or NULL if the matrix could not be allocated.
  */
 GF2_MATRIX create(const size_t rows, const size_t cols);
 
 /**
  * Creates a 'dim by dim' identity matrix.
  * @param dim[in] the dimension of the matrix.
- * @return a GF2_MATRIX pointer.
+ * @return a GF2_MATRIX pointer, or NULL if the matrix could not be allocated.
  */
 GF2_MATRIX createIdentityMatrix(const size_t dim);
 
@@ -44,13 +59,74 @@ GF2_ELEM getValue(const size_t row, const size_t col, const GF2_MATRIX m);
  * Sets a value in the GF2_MATRIX.
  * @param[in] row the row in matrix {row >=1,row<=dim}
  * @param[in] col the column in the matrix {col >=1,col <=dim}
- * @param[in] e the element which to insert into the matrix.
+ * @param[in] e the element which to insert into the matrix; only its lowest bit is used.
  * @param[in] m the matrix from which to retrieve element.
  */
 void setValue(const size_t row, const size_t col, const GF2_ELEM e, GF2_MATRIX m);
 
+/**
+ * Retrieves the packed words of a row, for operating on 64 elements at a time.
+ * @param[in] row the row in matrix {row >=1,row<=rows}
+ * @param[in] m the matrix.
+ * @return the row's m->stride words; bits past m->cols must be left at 0.
+ */
+static inline GF2_WORD* GF2_row(const size_t row, const GF2_MATRIX m) {
+    return m->m + (row - 1)*m->stride;
+}
+
+/**
+ * Creates a copy of a matrix.
+ * @param[in] m the matrix to copy.
+ * @return a GF2_MATRIX pointer, or NULL if the matrix could not be allocated.
+ */
+GF2_MATRIX GF2_copy(const GF2_MATRIX m);
+
+/**
+ * Sets every element of a matrix to 0.
+ * @param[in] m the matrix.
+ */
+void GF2_clear(GF2_MATRIX m);
+
+/**
+ * @param[in] a a matrix.
+ * @param[in] b another matrix.
+ * @return 1 if the matrices have the same dimensions and elements, otherwise 0.
+ */
+int GF2_equal(const GF2_MATRIX a, const GF2_MATRIX b);
+
+/**
+ * Swaps two rows of a matrix.
+ * @param[in] r1 a row in the matrix {r1 >=1,r1<=rows}
+ * @param[in] r2 another row in the matrix {r2 >=1,r2<=rows}
+ * @param[in] m the matrix.
+ */
+void GF2_swapRows(const size_t r1, const size_t r2, GF2_MATRIX m);
+
+/**
+ * Adds one row to another: row dst = row dst + row src, which over GF(2) is an XOR.
+ * @param[in] dst the row that is updated {dst >=1,dst<=rows}
+ * @param[in] src the row that is added {src >=1,src<=rows}
+ * @param[in] m the matrix.
+ */
+void GF2_addRow(const size_t dst, const size_t src, GF2_MATRIX m);
+
+/**
+ * Sets every element of a matrix to 0 or 1 at random. The same seed gives the same matrix.
+ * @param[in] seed the seed of the generator.
+ * @param[in] m the matrix.
+ */
+void GF2_randomize(const uint64_t seed, GF2_MATRIX m);
+
+/**
+ * @param[in] m the matrix.
+ * @return the number of elements that are 1.
+ */
+size_t GF2_weight(const GF2_MATRIX m);
+
 /**
  * Print a GF2_MATRIX to the screen.
  * @param[in] the matrix which to print.
  */
 void GF2_print(GF2_MATRIX m);
+
+#endif // GF2_MATRIX_H
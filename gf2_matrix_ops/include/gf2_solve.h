@@ -0,0 +1,56 @@
+#ifndef GF2_SOLVE_H
+#define GF2_SOLVE_H
+
+#include "gf2_matrix.h"
+
+/*
+ * Linear systems over GF(2). Everything here is built on GF2_reduceM4RI() (see gf2_m4r.h), which
+ * eliminates 64 columns per pass with AVX2/AVX-512 row XORs and spreads the rows of large
+ * matrices over threads. Inverses are computed by GF2_invertM4RI() on the same elimination.
+ * Vectors are 1 x n matrices, as in gf2_arith.h.
+ */
+
+typedef enum _gf2_status {
+    GF2_SOLVED = 0,              // x holds a solution.
+    GF2_INCONSISTENT = 1,        // A x = b has no solution; rank and nullspace are still set.
+    GF2_NO_MEMORY = 2            // Nothing is set.
+} GF2_STATUS;
+
+typedef struct _gf2_solution {
+    GF2_MATRIX x;                // 1 x N solution with every free variable 0, or NULL.
+    size_t rank;                 // Rank of A.
+    GF2_MATRIX nullspace;        // (N - rank) x N; its rows are a basis of the nullspace of A.
+} GF2_SOLUTION;
+
+/**
+ * Reduces a matrix in place to reduced row echelon form.
+ * @param[in] m the matrix.
+ * @param[out] pivots receives the pivot column (counting from 1) of each of the first 'rank' rows;
+ * may be NULL, otherwise room for min(rows, cols) columns.
+ * @return the rank of m, or SIZE_MAX if memory ran out.
+ */
+size_t GF2_rref(GF2_MATRIX m, size_t *pivots);
+
+/**
+ * @param[in] a an M x N matrix.
+ * @return an (N - rank) x N matrix whose rows are a basis of the vectors x with a * x^T = 0, or
+ * NULL if memory ran out.
+ */
+GF2_MATRIX GF2_nullspace(const GF2_MATRIX a);
+
+/**
+ * Solves A x^T = b^T. Every solution is s->x plus a sum of rows of s->nullspace.
+ * @param[in] a an M x N matrix.
+ * @param[in] b a 1 x M vector.
+ * @param[out] s the solution, rank and nullspace; free with GF2_freeSolution().
+ * @return GF2_SOLVED, or why there is no solution.
+ */
+GF2_STATUS GF2_solve(const GF2_MATRIX a, const GF2_MATRIX b, GF2_SOLUTION *s);
+
+/**
+ * Destroys the matrices of a solution.
+ * @param[in] s the solution.
+ */
+void GF2_freeSolution(GF2_SOLUTION *s);
+
+#endif // GF2_SOLVE_H
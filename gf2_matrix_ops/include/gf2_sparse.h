@@ -0,0 +1,108 @@
+#ifndef GF2_SPARSE_H
+#define GF2_SPARSE_H
+
+#include "gf2_matrix.h"
+
+/*
+ * Sparse GF(2) matrices for matrices that are almost all zero, such as LDPC parity checks and
+ * sieve relation matrices. Only the positions of the ones are stored, in compressed sparse row
+ * (CSR) form, so memory grows with the number of ones (4 bytes each, plus 8 bytes per row) rather
+ * than with rows*cols. The compressed sparse column (CSC) form of a matrix is the CSR form of its
+ * transpose; see GF2_sparseTranspose(). Vectors are dense 1 x n matrices, as in gf2_arith.h.
+ * Rows and columns are limited to 2^32 each.
+ */
+
+// Most vectors GF2_sparseNullspace() returns: Block Lanczos works on one 64-bit word of vectors.
+#define GF2_SPARSE_NULLSPACE_MAX GF2_WORD_BITS
+
+typedef struct _sparse_matrix {
+    size_t rows;         // Rows in the matrix
+    size_t cols;         // Columns in the matrix
+    size_t ones;         // Elements that are 1
+    size_t *start;       // rows + 1 offsets into col; row i (counting from 0) is col[start[i]] ..
+                         // col[start[i + 1] - 1].
+    uint32_t *col;       // Column of each 1 (counting from 0), ascending within each row.
+} SparseMatrix;
+
+typedef SparseMatrix* GF2_SPARSE;
+
+/**
+ * Creates a sparse matrix from the positions of its ones. A position given twice cancels out,
+ * since the entries are added over GF(2).
+ * @param[in] rows the number of rows in the matrix.
+ * @param[in] cols the number of columns in the matrix.
+ * @param[in] count the number of positions.
+ * @param[in] row the row of each position {row >=1,row<=rows}
+ * @param[in] col the column of each position {col >=1,col<=cols}
+ * @return a GF2_SPARSE pointer, or NULL if the matrix could not be allocated.
+ */
+GF2_SPARSE GF2_sparseCreate(const size_t rows, const size_t cols, const size_t count,
+                            const size_t *row, const size_t *col);
+
+/**
+ * @param[in] m a dense matrix.
+ * @return the sparse form of m, or NULL if it could not be allocated.
+ */
+GF2_SPARSE GF2_sparseFromDense(const GF2_MATRIX m);
+
+/**
+ * @param[in] a a sparse matrix.
+ * @return the dense form of a, or NULL if it could not be allocated.
+ */
+GF2_MATRIX GF2_sparseToDense(const GF2_SPARSE a);
+
+/**
+ * Transposes a sparse matrix, which also converts between the CSR and CSC forms.
+ * @param[in] a an M x N sparse matrix.
+ * @return the N x M transpose of a, or NULL if it could not be allocated.
+ */
+GF2_SPARSE GF2_sparseTranspose(const GF2_SPARSE a);
+
+/**
+ * Destroys a sparse matrix.
+ * @param[in] a a GF2_SPARSE pointer.
+ */
+void GF2_sparseDestroy(GF2_SPARSE a);
+
+/**
+ * Retrieves a value from a sparse matrix by binary search of its row.
+ * @param[in] row the row in the matrix {row >=1,row<=rows}
+ * @param[in] col the column in the matrix {col >=1,col<=cols}
+ * @param[in] a the matrix.
+ * @return the value at (row,col), 0 or 1.
+ */
+GF2_ELEM GF2_sparseGetValue(const size_t row, const size_t col, const GF2_SPARSE a);
+
+/**
+ * Multiplies a sparse matrix by a column vector, given as a row vector.
+ * @param[in] a an M x N sparse matrix.
+ * @param[in] x a 1 x N vector.
+ * @return the 1 x M vector (a * x^T)^T, or NULL if it could not be allocated.
+ */
+GF2_MATRIX GF2_sparseMulVec(const GF2_SPARSE a, const GF2_MATRIX x);
+
+/**
+ * Multiplies a sparse matrix by 64 column vectors at once. Bit v of word j of x is element j of
+ * vector v, so each 1 in a costs one word XOR for all 64 products.
+ * @param[in] a an M x N sparse matrix.
+ * @param[in] x N words.
+ * @param[out] y M words; bit v of word i receives element i of a times vector v.
+ */
+void GF2_sparseMulBlock(const GF2_SPARSE a, const GF2_WORD *x, GF2_WORD *y);
+
+/**
+ * Finds vectors x with a * x^T = 0 without forming a dense matrix. The matrix is first pruned as
+ * in structured Gaussian elimination: rows with a single 1 force their column to 0, and columns
+ * far in excess of the rows are set to 0. What is left is reduced densely when it is small, and
+ * otherwise solved with Montgomery's Block Lanczos algorithm in memory proportional to its ones
+ * and columns.
+ * @param[in] a an M x N sparse matrix.
+ * @param[in] seed the seed of Block Lanczos' random start; the same seed gives the same result.
+ * @return a k x N matrix whose rows are linearly independent vectors of the nullspace of a, with
+ * k <= GF2_SPARSE_NULLSPACE_MAX; the whole basis when the nullspace is smaller than that, except
+ * that Block Lanczos can occasionally miss a dimension. NULL if memory ran out or Block Lanczos
+ * failed to converge.
+ */
+GF2_MATRIX GF2_sparseNullspace(const GF2_SPARSE a, const uint64_t seed);
+
+#endif // GF2_SPARSE_H
@@ -0,0 +1,425 @@
+#include "gf2_arith.h"
+#include "gf2_m4r.h"
+#include "gf2_matrix.h"
+#include "gf2_solve.h"
+#include "gf2_sparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Times the packed operations against element-wise versions written on getValue()/setValue(), the
+ * way callers wrote them before the arithmetic API existed, the Four Russians algorithms and
+ * solver against the plain packed ones, and the sparse operations against dense ones. Checks that
+ * both sides of each comparison agree.
+ */
+
+#define MIN_SECONDS 0.2          // Each operation is repeated until it has run this long.
+#define SPARSE_ONES 10           // Ones per column of the sparse input.
+#define SPARSE_EXCESS 32         // Columns of the sparse input beyond its rows.
+
+typedef struct _inputs {
+    GF2_MATRIX a, b, x;
+    GF2_MATRIX inv;              // An invertible matrix.
+    GF2_SPARSE s;                // An N x (N + SPARSE_EXCESS) sparse matrix.
+    GF2_MATRIX sd;               // s as a dense matrix.
+    GF2_MATRIX sx;               // A 1 x (N + SPARSE_EXCESS) vector.
+} Inputs;
+
+typedef uint64_t (*Op)(const Inputs *in);
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/**
+ * Hashes and destroys a result so that results can be compared without keeping them.
+ * @param[in] m the result.
+ * @return an FNV-1a hash of the dimensions and elements of m.
+ */
+static uint64_t digest(GF2_MATRIX m) {
+    size_t i, n = m->rows*m->stride;
+    uint64_t h = 0xCBF29CE484222325ULL;
+    h = (h ^ m->rows) * 0x100000001B3ULL;
+    h = (h ^ m->cols) * 0x100000001B3ULL;
+    for(i = 0; i < n; i++) {
+        h = (h ^ m->m[i]) * 0x100000001B3ULL;
+    }
+    destroy(m);
+    return h;
+}
+
+//---- Element-wise baselines ----
+
+static uint64_t addElements(const Inputs *in) {
+    size_t r, c;
+    GF2_MATRIX s = create(in->a->rows, in->a->cols);
+    for(r = 1; r <= s->rows; r++) {
+        for(c = 1; c <= s->cols; c++) {
+            setValue(r, c, getValue(r, c, in->a) ^ getValue(r, c, in->b), s);
+        }
+    }
+    return digest(s);
+}
+
+static uint64_t mulVecElements(const Inputs *in) {
+    size_t r, c;
+    GF2_MATRIX y = create(1, in->a->rows);
+    for(r = 1; r <= in->a->rows; r++) {
+        GF2_ELEM e = 0;
+        for(c = 1; c <= in->a->cols; c++) {
+            e ^= getValue(r, c, in->a) & getValue(1, c, in->x);
+        }
+        setValue(1, r, e, y);
+    }
+    return digest(y);
+}
+
+static uint64_t multiplyElements(const Inputs *in) {
+    size_t r, c, k;
+    GF2_MATRIX p = create(in->a->rows, in->b->cols);
+    for(r = 1; r <= p->rows; r++) {
+        for(c = 1; c <= p->cols; c++) {
+            GF2_ELEM e = 0;
+            for(k = 1; k <= in->a->cols; k++) {
+                e ^= getValue(r, k, in->a) & getValue(k, c, in->b);
+            }
+            setValue(r, c, e, p);
+        }
+    }
+    return digest(p);
+}
+
+static uint64_t transposeElements(const Inputs *in) {
+    size_t r, c;
+    GF2_MATRIX t = create(in->a->cols, in->a->rows);
+    for(r = 1; r <= in->a->rows; r++) {
+        for(c = 1; c <= in->a->cols; c++) {
+            setValue(c, r, getValue(r, c, in->a), t);
+        }
+    }
+    return digest(t);
+}
+
+static uint64_t rankElements(const Inputs *in) {
+    size_t rank = 0, r, c, k;
+    GF2_MATRIX e = GF2_copy(in->a);
+    for(c = 1; c <= e->cols && rank < e->rows; c++) {
+        for(r = rank + 1; r <= e->rows && !getValue(r, c, e); r++);
+        if(r > e->rows) {
+            continue;
+        }
+        rank++;
+        for(k = 1; k <= e->cols; k++) {
+            GF2_ELEM t = getValue(r, k, e);
+            setValue(r, k, getValue(rank, k, e), e);
+            setValue(rank, k, t, e);
+        }
+        for(r = rank + 1; r <= e->rows; r++) {
+            if(getValue(r, c, e)) {
+                for(k = c; k <= e->cols; k++) {
+                    setValue(r, k, getValue(r, k, e) ^ getValue(rank, k, e), e);
+                }
+            }
+        }
+    }
+    destroy(e);
+    return rank;
+}
+
+//---- Packed operations ----
+
+static uint64_t addPacked(const Inputs *in) {
+    return digest(GF2_add(in->a, in->b));
+}
+
+static uint64_t mulVecPacked(const Inputs *in) {
+    return digest(GF2_mulVec(in->a, in->x));
+}
+
+static uint64_t multiplyPacked(const Inputs *in) {
+    return digest(GF2_multiply(in->a, in->b));
+}
+
+static uint64_t transposePacked(const Inputs *in) {
+    return digest(GF2_transpose(in->a));
+}
+
+static uint64_t rankPacked(const Inputs *in) {
+    return GF2_rank(in->a);
+}
+
+/**
+ * Plain Gauss-Jordan inversion on packed rows, one row XOR per elimination.
+ */
+static uint64_t invertPacked(const Inputs *in) {
+    size_t n = in->inv->rows, c, r;
+    GF2_MATRIX e = GF2_copy(in->inv);
+    GF2_MATRIX inv = createIdentityMatrix(n);
+    for(c = 1; c <= n; c++) {
+        for(r = c; !getValue(r, c, e); r++);
+        GF2_swapRows(r, c, e);
+        GF2_swapRows(r, c, inv);
+        for(r = 1; r <= n; r++) {
+            if(r != c && getValue(r, c, e)) {
+                GF2_addRow(r, c, e);
+                GF2_addRow(r, c, inv);
+            }
+        }
+    }
+    destroy(e);
+    return digest(inv);
+}
+
+/**
+ * Solves inv * x^T = x^T by plain Gauss-Jordan elimination of [inv | x].
+ */
+static uint64_t solvePacked(const Inputs *in) {
+    size_t n = in->inv->rows, c, r;
+    GF2_MATRIX e = create(n, n + 1);
+    GF2_MATRIX x = create(1, n);
+    for(r = 1; r <= n; r++) {
+        memcpy(GF2_row(r, e), GF2_row(r, in->inv), in->inv->stride*sizeof(GF2_WORD));
+        setValue(r, n + 1, getValue(1, r, in->x), e);
+    }
+    for(c = 1; c <= n; c++) {
+        for(r = c; !getValue(r, c, e); r++);
+        GF2_swapRows(r, c, e);
+        for(r = 1; r <= n; r++) {
+            if(r != c && getValue(r, c, e)) {
+                GF2_addRow(r, c, e);
+            }
+        }
+    }
+    for(r = 1; r <= n; r++) {
+        setValue(1, r, getValue(r, n + 1, e), x);
+    }
+    destroy(e);
+    return digest(x);
+}
+
+//---- Four Russians ----
+
+static uint64_t multiplyM4RM(const Inputs *in) {
+    return digest(GF2_multiplyM4RM(in->a, in->b));
+}
+
+static uint64_t multiplyStrassen(const Inputs *in) {
+    return digest(GF2_multiplyStrassen(in->a, in->b));
+}
+
+static uint64_t invertM4RI(const Inputs *in) {
+    return digest(GF2_invertM4RI(in->inv));
+}
+
+static uint64_t solveM4RI(const Inputs *in) {
+    GF2_SOLUTION s;
+    GF2_solve(in->inv, in->x, &s);
+    uint64_t h = digest(s.x);
+    s.x = NULL;
+    GF2_freeSolution(&s);
+    return h;
+}
+
+//---- Sparse ----
+
+static uint64_t mulVecDense(const Inputs *in) {
+    return digest(GF2_mulVec(in->sd, in->sx));
+}
+
+static uint64_t mulVecSparse(const Inputs *in) {
+    return digest(GF2_sparseMulVec(in->s, in->sx));
+}
+
+// The two return different bases of the nullspace, so only their sizes are compared; with
+// SPARSE_EXCESS columns over the rows it is below GF2_SPARSE_NULLSPACE_MAX.
+static uint64_t nullspaceDense(const Inputs *in) {
+    GF2_MATRIX null = GF2_nullspace(in->sd);
+    uint64_t rows = null->rows;
+    destroy(null);
+    return rows;
+}
+
+static uint64_t nullspaceSparse(const Inputs *in) {
+    GF2_MATRIX null = GF2_sparseNullspace(in->s, 1);
+    uint64_t rows = null->rows;
+    destroy(null);
+    return rows;
+}
+
+typedef struct _benchmark {
+    const char *name;
+    Op baseline;
+    Op optimized;
+    int cubic;                   // O(n^3) element-wise; only run up to the baseline limit.
+} Benchmark;
+
+static const Benchmark BENCHMARKS[] = {
+    { "add",       addElements,       addPacked,        0 },
+    { "mulvec",    mulVecElements,    mulVecPacked,     0 },
+    { "multiply",  multiplyElements,  multiplyPacked,   1 },
+    { "transpose", transposeElements, transposePacked,  0 },
+    { "rank",      rankElements,      rankPacked,       1 },
+};
+
+static const Benchmark M4R_BENCHMARKS[] = {
+    { "m4rm",      multiplyPacked,    multiplyM4RM,     0 },
+    { "strassen",  multiplyPacked,    multiplyStrassen, 0 },
+    { "m4ri",      invertPacked,      invertM4RI,       0 },
+    { "solve",     solvePacked,       solveM4RI,        0 },
+};
+
+static const Benchmark SPARSE_BENCHMARKS[] = {
+    { "spmv",      mulVecDense,       mulVecSparse,     0 },
+    { "nullspace", nullspaceDense,    nullspaceSparse,  0 },
+};
+
+/**
+ * Creates a sparse matrix with SPARSE_ONES ones in random rows of each column.
+ * @param[in] seed the seed of the generator.
+ * @param[in] rows the number of rows.
+ * @param[in] cols the number of columns.
+ * @return the matrix, or NULL if it could not be allocated.
+ */
+static GF2_SPARSE randomSparse(uint64_t seed, size_t rows, size_t cols) {
+    size_t count = cols*SPARSE_ONES, k;
+    size_t *row = (size_t*) malloc(count*sizeof(size_t));
+    size_t *col = (size_t*) malloc(count*sizeof(size_t));
+    GF2_MATRIX picks = create(1, count*GF2_WORD_BITS);
+    GF2_SPARSE s = NULL;
+    if(row && col && picks) {
+        GF2_randomize(seed, picks);
+        for(k = 0; k < count; k++) {
+            row[k] = 1 + picks->m[k] % rows;
+            col[k] = 1 + k / SPARSE_ONES;
+        }
+        s = GF2_sparseCreate(rows, cols, count, row, col);
+    }
+    free(row);
+    free(col);
+    destroy(picks);
+    return s;
+}
+
+/**
+ * @param[in] op the operation.
+ * @param[in] in its inputs.
+ * @param[out] result the result of the last run.
+ * @return seconds per run.
+ */
+static double timeOp(Op op, const Inputs *in, uint64_t *result) {
+    size_t runs = 0;
+    double start = now(), elapsed;
+    do {
+        *result = op(in);
+        runs++;
+        elapsed = now() - start;
+    } while(elapsed < MIN_SECONDS);
+    return elapsed / runs;
+}
+
+/**
+ * Runs a set of benchmarks and prints a row for each.
+ * @param[in] benchmarks the benchmarks.
+ * @param[in] count the number of benchmarks.
+ * @param[in] in the inputs.
+ * @param[in] baselineMax the largest size for O(n^3) element-wise baselines.
+ * @return 1 if any results disagreed, otherwise 0.
+ */
+static int runBenchmarks(const Benchmark *benchmarks, size_t count, const Inputs *in,
+                         size_t baselineMax) {
+    size_t i, n = in->a->rows;
+    int failed = 0;
+    for(i = 0; i < count; i++) {
+        const Benchmark *b = &benchmarks[i];
+        uint64_t expected, got;
+        double optimized = timeOp(b->optimized, in, &got);
+        if(b->cubic && n > baselineMax) {
+            printf("%-10s %6zu %16s %11.3f ms %10s\n", b->name, n, "-", optimized*1e3, "-");
+            continue;
+        }
+        double baseline = timeOp(b->baseline, in, &expected);
+        printf("%-10s %6zu %13.3f ms %11.3f ms %9.1fx%s\n", b->name, n, baseline*1e3,
+               optimized*1e3, baseline / optimized, expected == got ? "" : "  MISMATCH");
+        failed |= expected != got;
+    }
+    return failed;
+}
+
+static void usage(void) {
+    printf("USAGE: gf2_matrix_bench [-b MAX] [N ...]\n\n");
+    printf("    Times GF(2) matrix operations on random N x N matrices (default: 256 1024 4096)\n");
+    printf("    against element-wise getValue()/setValue() loops, and the Four Russians\n");
+    printf("    multiply, inverse and solver against plain packed ones. The O(n^3) element-wise\n");
+    printf("    baselines are only run up to N = MAX (default: 1024). Sparse matrix-vector\n");
+    printf("    products and nullspaces are timed against dense ones on N x (N + %d)\n",
+           SPARSE_EXCESS);
+    printf("    matrices with %d ones per column.\n", SPARSE_ONES);
+}
+
+int main(int argc, char **argv) {
+    size_t sizes[64], count = 0, baselineMax = 1024, s, i;
+    int failed = 0;
+
+    for(i = 1; i < (size_t) argc; i++) {
+        if(!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            usage();
+            return 0;
+        } else if(!strcmp(argv[i], "-b") && i + 1 < (size_t) argc) {
+            baselineMax = strtoull(argv[++i], NULL, 10);
+        } else if(count < sizeof(sizes) / sizeof(sizes[0]) && strtoull(argv[i], NULL, 10) > 0) {
+            sizes[count++] = strtoull(argv[i], NULL, 10);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if(count == 0) {
+        sizes[count++] = 256;
+        sizes[count++] = 1024;
+        sizes[count++] = 4096;
+    }
+
+    printf("%-10s %6s %16s %14s %10s\n", "op", "n", "baseline", "optimized", "speedup");
+    for(s = 0; s < count; s++) {
+        size_t n = sizes[s];
+        uint64_t seed = 4;
+        Inputs in = { create(n, n), create(n, n), create(1, n), create(n, n),
+                      randomSparse(5, n, n + SPARSE_EXCESS), NULL, create(1, n + SPARSE_EXCESS) };
+        GF2_MATRIX check = NULL;
+        in.sd = in.s ? GF2_sparseToDense(in.s) : NULL;
+        if(!in.a || !in.b || !in.x || !in.inv || !in.sd || !in.sx) {
+            fprintf(stderr, "ERROR: cannot allocate %zu x %zu matrices\n", n, n);
+            return 1;
+        }
+        GF2_randomize(1, in.a);
+        GF2_randomize(2, in.b);
+        GF2_randomize(3, in.x);
+        GF2_randomize(6, in.sx);
+        // About 29% of random matrices are invertible.
+        do {
+            GF2_randomize(seed++, in.inv);
+        } while(!(check = GF2_invertM4RI(in.inv)));
+        destroy(check);
+
+        failed |= runBenchmarks(BENCHMARKS, sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]), &in,
+                                baselineMax);
+        failed |= runBenchmarks(M4R_BENCHMARKS, sizeof(M4R_BENCHMARKS) / sizeof(M4R_BENCHMARKS[0]),
+                                &in, baselineMax);
+        failed |= runBenchmarks(SPARSE_BENCHMARKS,
+                                sizeof(SPARSE_BENCHMARKS) / sizeof(SPARSE_BENCHMARKS[0]), &in,
+                                baselineMax);
+        destroy(in.a);
+        destroy(in.b);
+        destroy(in.x);
+        destroy(in.inv);
+        GF2_sparseDestroy(in.s);
+        destroy(in.sd);
+        destroy(in.sx);
+    }
+    return failed;
+}
@@ -0,0 +1,161 @@
+#include "gf2_arith.h"
+#include "gf2_simd.h"
+
+#include <assert.h>
+
+/**
+ * Transposes a 64x64 bit block in place: bit c of a[r] is swapped with bit r of a[c]. The block is
+ * split into four 32x32 quadrants, the two off-diagonal ones are swapped with shifts and masks on
+ * all 64 words at once, and the same is repeated for 16x16 quadrants down to single bits; 6
+ * rounds of 32 word pairs instead of 4096 single-bit moves.
+ * @param[in] a the 64 words of the block, one per row.
+ */
+static void transpose64(GF2_WORD a[64]) {
+    size_t j, k;
+    GF2_WORD mask = 0x00000000FFFFFFFFULL, t;
+    for(j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for(k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            t = ((a[k] >> j) ^ a[k | j]) & mask;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+GF2_MATRIX GF2_add(const GF2_MATRIX a, const GF2_MATRIX b) {
+    GF2_MATRIX c = GF2_copy(a);
+    if(c) {
+        GF2_addTo(c, b);
+    }
+    return c;
+}
+
+void GF2_addTo(GF2_MATRIX dst, const GF2_MATRIX src) {
+    assert(dst != NULL && src != NULL);
+    assert(dst->rows == src->rows && dst->cols == src->cols);
+    gf2XorRow(dst->m, src->m, dst->rows*dst->stride);
+}
+
+GF2_MATRIX GF2_mulVec(const GF2_MATRIX a, const GF2_MATRIX x) {
+    assert(a != NULL && x != NULL);
+    assert(x->rows == 1 && x->cols == a->cols);
+    size_t i, w;
+    GF2_MATRIX y = create(1, a->rows);
+    if(!y) {
+        return NULL;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Element i of the product is the parity of the ones in (row i AND x). The parity of a sum of
+    // popcounts is the parity of the popcount of an XOR, so the ANDed words are folded with XOR
+    // and only one popcount is needed per row.
+    for(i = 0; i < a->rows; i++) {
+        const GF2_WORD *row = a->m + i*a->stride;
+        GF2_WORD acc = 0;
+        for(w = 0; w < a->stride; w++) {
+            acc ^= row[w] & x->m[w];
+        }
+        GF2_WORD parity = (GF2_WORD) (__builtin_popcountll(acc) & 1);
+        y->m[i / GF2_WORD_BITS] |= parity << (i % GF2_WORD_BITS);
+    }
+    return y;
+}
+
+GF2_MATRIX GF2_multiply(const GF2_MATRIX a, const GF2_MATRIX b) {
+    assert(a != NULL && b != NULL);
+    assert(a->cols == b->rows);
+    size_t i, w;
+    GF2_MATRIX c = create(a->rows, b->cols);
+    if(!c) {
+        return NULL;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Row i of the product is the sum of the rows k of b for which a(i,k) is 1, so rather than
+    // computing every element as a dot product, each set bit of a adds a whole row of b into c,
+    // 64 elements per XOR. Rows of a, b and c are all read front to back.
+    for(i = 0; i < a->rows; i++) {
+        const GF2_WORD *arow = a->m + i*a->stride;
+        GF2_WORD *crow = c->m + i*c->stride;
+        for(w = 0; w < a->stride; w++) {
+            GF2_WORD bits = arow[w];
+            while(bits) {
+                const GF2_WORD *brow = b->m + (w*GF2_WORD_BITS + __builtin_ctzll(bits))*b->stride;
+                gf2XorRow(crow, brow, c->stride);
+                bits &= bits - 1;
+            }
+        }
+    }
+    return c;
+}
+
+GF2_MATRIX GF2_transpose(const GF2_MATRIX m) {
+    assert(m != NULL);
+    size_t rb, w, k;
+    GF2_WORD block[64];
+    GF2_MATRIX t = create(m->cols, m->rows);
+    if(!t) {
+        return NULL;
+    }
+
+    //---- OPTIMIZATION: ----
+    // The matrix is transposed one 64x64 tile at a time: 64 words are gathered down a column of
+    // words, transposed in registers and scattered across a column of words of the result. The
+    // tiles of a band of 64 rows are visited left to right, so each cache line of the band is
+    // loaded once and serves 8 tiles. Rows past the end of m are zero, which keeps the padding
+    // bits of t zero, and columns past the end of m would land in rows t does not have.
+    for(rb = 0; rb < m->rows; rb += GF2_WORD_BITS) {
+        size_t rows = m->rows - rb < GF2_WORD_BITS ? m->rows - rb : GF2_WORD_BITS;
+        for(w = 0; w*GF2_WORD_BITS < m->cols; w++) {
+            for(k = 0; k < rows; k++) {
+                block[k] = m->m[(rb + k)*m->stride + w];
+            }
+            for(; k < GF2_WORD_BITS; k++) {
+                block[k] = 0;
+            }
+            transpose64(block);
+
+            size_t cols = m->cols - w*GF2_WORD_BITS;
+            cols = cols < GF2_WORD_BITS ? cols : GF2_WORD_BITS;
+            for(k = 0; k < cols; k++) {
+                t->m[(w*GF2_WORD_BITS + k)*t->stride + rb / GF2_WORD_BITS] = block[k];
+            }
+        }
+    }
+    return t;
+}
+
+size_t GF2_rank(const GF2_MATRIX m) {
+    assert(m != NULL);
+    size_t rank = 0, col, r;
+    GF2_MATRIX e = GF2_copy(m);
+    if(!e) {
+        return SIZE_MAX;
+    }
+
+    for(col = 0; col < e->cols && rank < e->rows; col++) {
+        size_t word = col / GF2_WORD_BITS;
+        GF2_WORD bit = (GF2_WORD) 1 << (col % GF2_WORD_BITS);
+        for(r = rank; r < e->rows && !(e->m[r*e->stride + word] & bit); r++);
+        if(r == e->rows) {
+            continue;
+        }
+        if(r != rank) {
+            GF2_swapRows(r + 1, rank + 1, e);
+        }
+
+        //---- OPTIMIZATION: ----
+        // Words left of the pivot column are already zero in the pivot row, so elimination only
+        // XORs from the pivot's word onwards.
+        const GF2_WORD *pivot = e->m + rank*e->stride;
+        for(r = rank + 1; r < e->rows; r++) {
+            GF2_WORD *row = e->m + r*e->stride;
+            if(row[word] & bit) {
+                gf2XorRow(row + word, pivot + word, e->stride - word);
+            }
+        }
+        rank++;
+    }
+    destroy(e);
+    return rank;
+}
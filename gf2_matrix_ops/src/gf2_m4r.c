@@ -0,0 +1,384 @@
+#include "gf2_m4r.h"
+
+#include "gf2_arith.h"
+#include "gf2_simd.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#define M4R_K 8                                   // Rows combined by one table.
+#define M4R_ENTRIES (1 << M4R_K)                  // Entries in one table.
+#define M4R_TABLES (GF2_WORD_BITS / M4R_K)        // Tables covering one word of bits.
+
+// Tables are built and applied this many words of a row at a time, so that the 8 tables
+// (8 * 256 * 64 words = 1 MiB) stay in L2 while the rows stream past them.
+#define M4R_STRIP_WORDS 64
+
+// Table lookups are spread over threads (with OpenMP) once a pass touches this many words.
+#define M4R_PARALLEL_WORDS (1 << 15)
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/**
+ * @param[in] m a matrix.
+ * @return the number of words of each row that can hold ones.
+ */
+static size_t usedWords(const GF2_MATRIX m) {
+    return (m->cols + GF2_WORD_BITS - 1) / GF2_WORD_BITS;
+}
+
+/**
+ * Fills a table with every sum of up to M4R_K rows. Entries are visited in Gray-code order, where
+ * consecutive entries differ in one row, so each entry costs a single row XOR.
+ * @param[out] table M4R_ENTRIES entries of 'words' words; entry i is the sum of rows[t] for every
+ * bit t set in i.
+ * @param[in] rows the rows to combine, each read from its first word.
+ * @param[in] count the number of rows, at most M4R_K; entries using missing rows are left unset
+ * and must not be looked up.
+ * @param[in] words the words of each row to combine.
+ */
+static void buildTable(GF2_WORD *table, const GF2_WORD *const *rows, size_t count, size_t words) {
+    size_t i;
+    memset(table, 0, words*sizeof(GF2_WORD));
+    for(i = 1; i < ((size_t) 1 << count); i++) {
+        const GF2_WORD *prev = table + ((i - 1) ^ ((i - 1) >> 1))*words;
+        gf2XorRows2(table + (i ^ (i >> 1))*words, prev, rows[__builtin_ctzll(i)], words);
+    }
+}
+
+/**
+ * Adds the table entries selected by the 8 bytes of an index to a row.
+ * @param[in] row the row, from the first word the tables cover.
+ * @param[in] tables M4R_TABLES tables built by buildTable().
+ * @param[in] index byte g selects the entry of table g.
+ * @param[in] words the words the tables cover.
+ */
+static void addEntries(GF2_WORD *row, const GF2_WORD *tables, GF2_WORD index, size_t words) {
+    size_t g, size = M4R_ENTRIES*words;
+    const GF2_WORD *t[M4R_TABLES];
+    for(g = 0; g < M4R_TABLES; g++) {
+        t[g] = tables + g*size + ((index >> (g*M4R_K)) & (M4R_ENTRIES - 1))*words;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Up to 64 row additions become 8 loads and XORs per word, and the row is loaded and stored
+    // once instead of once per addition.
+    gf2XorRows8(row, t, words);
+}
+
+/**
+ * Builds the M4R_TABLES tables for up to 64 consecutive rows; tables past the last row hold only
+ * their zero entry.
+ * @param[out] tables room for M4R_TABLES*M4R_ENTRIES*words words.
+ * @param[in] m the matrix.
+ * @param[in] first the first of the rows (counting from 0).
+ * @param[in] count the number of rows, at most 64.
+ * @param[in] word the first word of each row to combine.
+ * @param[in] words the words of each row to combine.
+ */
+static void buildTables(GF2_WORD *tables, const GF2_MATRIX m, size_t first, size_t count,
+                        size_t word, size_t words) {
+    size_t g, t;
+    const GF2_WORD *rows[M4R_K];
+    for(g = 0; g < M4R_TABLES; g++) {
+        size_t n = count > g*M4R_K ? MIN(count - g*M4R_K, M4R_K) : 0;
+        for(t = 0; t < n; t++) {
+            rows[t] = m->m + (first + g*M4R_K + t)*m->stride + word;
+        }
+        buildTable(tables + g*M4R_ENTRIES*words, rows, n, words);
+    }
+}
+
+/**
+ * @param[in] words the words each table entry holds.
+ * @return room for M4R_TABLES tables, or NULL.
+ */
+static GF2_WORD* allocTables(size_t words) {
+    size_t bytes = M4R_TABLES*M4R_ENTRIES*words*sizeof(GF2_WORD);
+    return (GF2_WORD*) aligned_alloc(GF2_ALIGNMENT, (bytes + GF2_ALIGNMENT - 1) /
+                                     GF2_ALIGNMENT*GF2_ALIGNMENT);
+}
+
+/**
+ * Packs the bits of a word selected by a mask into its low bits, keeping their order.
+ * @param[in] w the word.
+ * @param[in] mask the bits to keep.
+ * @return the selected bits of w, packed.
+ */
+static inline GF2_WORD gatherBits(GF2_WORD w, GF2_WORD mask) {
+#ifdef __BMI2__
+    return _pext_u64(w, mask);
+#else
+    GF2_WORD b = 0;
+    size_t t;
+    for(t = 0; mask; mask &= mask - 1, t++) {
+        b |= ((w >> __builtin_ctzll(mask)) & 1) << t;
+    }
+    return b;
+#endif
+}
+
+GF2_MATRIX GF2_multiplyM4RM(const GF2_MATRIX a, const GF2_MATRIX b) {
+    assert(a != NULL && b != NULL);
+    assert(a->cols == b->rows);
+    size_t i, s, w, words = usedWords(b);
+    size_t strip = MIN(words, M4R_STRIP_WORDS);
+    GF2_MATRIX c = create(a->rows, b->cols);
+    GF2_WORD *tables = allocTables(strip);
+    if(!c || !tables) {
+        destroy(c);
+        free(tables);
+        return NULL;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Word w of row i of a selects which of rows 64w..64w+63 of b are added into row i of c.
+    // The 8 tables for those 64 rows turn that into 8 lookups, and the tables are built once and
+    // shared by every row of a. Columns are processed in strips so the tables stay in cache.
+    for(s = 0; s < words; s += strip) {
+        size_t sw = MIN(strip, words - s);
+        for(w = 0; w*GF2_WORD_BITS < a->cols; w++) {
+            size_t first = w*GF2_WORD_BITS;
+            buildTables(tables, b, first, MIN(b->rows - first, GF2_WORD_BITS), s, sw);
+            #pragma omp parallel for schedule(static) if(a->rows*sw >= M4R_PARALLEL_WORDS)
+            for(i = 0; i < a->rows; i++) {
+                GF2_WORD index = a->m[i*a->stride + w];
+                if(index) {
+                    addEntries(c->m + i*c->stride + s, tables, index, sw);
+                }
+            }
+        }
+    }
+    free(tables);
+    return c;
+}
+
+/**
+ * Copies a block of a matrix into a new matrix. Parts of the block outside m are 0.
+ * @param[in] m the matrix.
+ * @param[in] row the first row of the block (counting from 0).
+ * @param[in] word the first word of the block.
+ * @param[in] rows the rows in the block.
+ * @param[in] cols the columns in the block, a multiple of GF2_WORD_BITS.
+ * @return the block, or NULL if it could not be allocated.
+ */
+static GF2_MATRIX copyBlock(const GF2_MATRIX m, size_t row, size_t word, size_t rows,
+                            size_t cols) {
+    size_t r, n, words;
+    GF2_MATRIX b = create(rows, cols);
+    if(!b) {
+        return NULL;
+    }
+    n = row < m->rows ? MIN(rows, m->rows - row) : 0;
+    words = word < usedWords(m) ? MIN(cols / GF2_WORD_BITS, usedWords(m) - word) : 0;
+    for(r = 0; r < n; r++) {
+        memcpy(b->m + r*b->stride, m->m + (row + r)*m->stride + word, words*sizeof(GF2_WORD));
+    }
+    return b;
+}
+
+/**
+ * Copies a block into a matrix, dropping the parts that fall outside it.
+ * @param[in] m the matrix.
+ * @param[in] b the block.
+ * @param[in] row the row of m the block starts at (counting from 0).
+ * @param[in] word the word of m the block starts at.
+ */
+static void placeBlock(GF2_MATRIX m, const GF2_MATRIX b, size_t row, size_t word) {
+    size_t r, n, words;
+    n = row < m->rows ? MIN(b->rows, m->rows - row) : 0;
+    words = word < usedWords(m) ? MIN(usedWords(b), usedWords(m) - word) : 0;
+    for(r = 0; r < n; r++) {
+        memcpy(m->m + (row + r)*m->stride + word, b->m + r*b->stride, words*sizeof(GF2_WORD));
+    }
+}
+
+/**
+ * @param[in] n a dimension.
+ * @return the size of the first half when splitting it for Strassen-Winograd, a whole number of
+ * words so that blocks can be copied word by word.
+ */
+static size_t splitSize(size_t n) {
+    size_t half = (n + 1) / 2;
+    return (half + GF2_WORD_BITS - 1) / GF2_WORD_BITS*GF2_WORD_BITS;
+}
+
+GF2_MATRIX GF2_multiplyStrassen(const GF2_MATRIX a, const GF2_MATRIX b) {
+    assert(a != NULL && b != NULL);
+    assert(a->cols == b->rows);
+    if(a->rows <= GF2_STRASSEN_CUTOFF || a->cols <= GF2_STRASSEN_CUTOFF ||
+       b->cols <= GF2_STRASSEN_CUTOFF) {
+        return GF2_multiplyM4RM(a, b);
+    }
+
+    size_t i, m1 = splitSize(a->rows), k1 = splitSize(a->cols), n1 = splitSize(b->cols);
+    GF2_MATRIX c = NULL;
+    enum { A11, A12, A21, A22, B11, B12, B21, B22,
+           S1, S2, S3, S4, T1, T2, T3, T4,
+           P1, P2, P3, P4, P5, P6, P7, COUNT };
+    GF2_MATRIX t[COUNT] = { NULL };
+
+    // The quadrants are padded with zeros to the size of the top-left one, so that the
+    // recursion only ever sees equal-sized blocks.
+    t[A11] = copyBlock(a, 0, 0, m1, k1);
+    t[A12] = copyBlock(a, 0, k1 / GF2_WORD_BITS, m1, k1);
+    t[A21] = copyBlock(a, m1, 0, m1, k1);
+    t[A22] = copyBlock(a, m1, k1 / GF2_WORD_BITS, m1, k1);
+    t[B11] = copyBlock(b, 0, 0, k1, n1);
+    t[B12] = copyBlock(b, 0, n1 / GF2_WORD_BITS, k1, n1);
+    t[B21] = copyBlock(b, k1, 0, k1, n1);
+    t[B22] = copyBlock(b, k1, n1 / GF2_WORD_BITS, k1, n1);
+    for(i = A11; i <= B22; i++) {
+        if(!t[i]) {
+            goto done;
+        }
+    }
+
+    // Winograd's form: 7 products and 15 additions, where subtraction is addition over GF(2).
+    if(!(t[S1] = GF2_add(t[A21], t[A22])) || !(t[S2] = GF2_add(t[S1], t[A11])) ||
+       !(t[S3] = GF2_add(t[A11], t[A21])) || !(t[S4] = GF2_add(t[A12], t[S2])) ||
+       !(t[T1] = GF2_add(t[B12], t[B11])) || !(t[T2] = GF2_add(t[B22], t[T1])) ||
+       !(t[T3] = GF2_add(t[B22], t[B12])) || !(t[T4] = GF2_add(t[T2], t[B21])) ||
+       !(t[P1] = GF2_multiplyStrassen(t[A11], t[B11])) ||
+       !(t[P2] = GF2_multiplyStrassen(t[A12], t[B21])) ||
+       !(t[P3] = GF2_multiplyStrassen(t[S4], t[B22])) ||
+       !(t[P4] = GF2_multiplyStrassen(t[A22], t[T4])) ||
+       !(t[P5] = GF2_multiplyStrassen(t[S1], t[T1])) ||
+       !(t[P6] = GF2_multiplyStrassen(t[S2], t[T2])) ||
+       !(t[P7] = GF2_multiplyStrassen(t[S3], t[T3])) ||
+       !(c = create(a->rows, b->cols))) {
+        goto done;
+    }
+
+    GF2_addTo(t[P6], t[P1]);     // U2 = P1 + P6
+    GF2_addTo(t[P7], t[P6]);     // U3 = U2 + P7
+    GF2_addTo(t[P6], t[P5]);     // U4 = U2 + P5
+    GF2_addTo(t[P6], t[P3]);     // C12 = U4 + P3
+    GF2_addTo(t[P4], t[P7]);     // C21 = U3 + P4
+    GF2_addTo(t[P7], t[P5]);     // C22 = U3 + P5
+    GF2_addTo(t[P1], t[P2]);     // C11 = P1 + P2
+
+    placeBlock(c, t[P1], 0, 0);
+    placeBlock(c, t[P6], 0, n1 / GF2_WORD_BITS);
+    placeBlock(c, t[P4], m1, 0);
+    placeBlock(c, t[P7], m1, n1 / GF2_WORD_BITS);
+
+done:
+    for(i = 0; i < COUNT; i++) {
+        destroy(t[i]);
+    }
+    return c;
+}
+
+size_t GF2_reduceM4RI(GF2_MATRIX m, const size_t pivotCols, size_t *pivots) {
+    assert(m != NULL);
+    assert(pivotCols <= m->cols);
+    size_t rank = 0, wb, i, j, s;
+    size_t words = usedWords(m);
+    size_t strip = MIN(words, M4R_STRIP_WORDS);
+    GF2_WORD *tables = allocTables(strip);
+    if(!tables) {
+        return SIZE_MAX;
+    }
+
+    for(wb = 0; wb*GF2_WORD_BITS < pivotCols && rank < m->rows; wb++) {
+        size_t first = rank, found = 0;
+        size_t limit = MIN(pivotCols - wb*GF2_WORD_BITS, GF2_WORD_BITS);
+        size_t width = words - wb;
+        GF2_WORD mask = 0, x;
+        GF2_WORD *pivot[GF2_WORD_BITS];
+        size_t pivotOf[GF2_WORD_BITS];
+
+        //---- OPTIMIZATION: ----
+        // Find the pivots of this word. Candidate rows are reduced against the pivots found so far
+        // before their bit is tested, and each new pivot is cleared from the earlier ones, so that
+        // the pivot rows are the identity on the pivot columns. Which rows need a pivot added is
+        // collected into a bit mask without branching and then walked set bit by set bit, so the
+        // only unpredictable branch is the loop exit rather than one per row.
+        for(j = 0; j < limit && first + found < m->rows; j++) {
+            GF2_WORD bit = (GF2_WORD) 1 << j, need = 0;
+            for(i = first + found; i < m->rows; i++) {
+                GF2_WORD *row = m->m + i*m->stride + wb;
+                for(x = row[0] & mask; x; x &= x - 1) {
+                    gf2XorRow(row, pivot[pivotOf[__builtin_ctzll(x)]], width);
+                }
+                if(row[0] & bit) {
+                    break;
+                }
+            }
+            if(i == m->rows) {
+                continue;
+            }
+            if(i != first + found) {
+                GF2_swapRows(i + 1, first + found + 1, m);
+            }
+            pivot[found] = m->m + (first + found)*m->stride + wb;
+            for(i = 0; i < found; i++) {
+                need |= ((pivot[i][0] >> j) & 1) << i;
+            }
+            for(x = need; x; x &= x - 1) {
+                gf2XorRow(pivot[__builtin_ctzll(x)], pivot[found], width);
+            }
+            if(pivots) {
+                pivots[first + found] = wb*GF2_WORD_BITS + j + 1;
+            }
+            pivotOf[j] = found++;
+            mask |= bit;
+        }
+        if(!found) {
+            continue;
+        }
+
+        //---- OPTIMIZATION: ----
+        // Clear the pivot columns from every other row with 8 table lookups per row. Rows are
+        // independent, so they are split over threads, and every row takes the same path: a row
+        // with nothing to clear looks up the zero entries. Strips are processed from the last to
+        // the first, because the first one holds the word that selects the table entries.
+        for(s = (width - 1) / strip*strip + strip; s > 0; ) {
+            size_t sw, others = m->rows - found;
+            s -= strip;
+            sw = MIN(strip, width - s);
+            buildTables(tables, m, first, found, wb + s, sw);
+            #pragma omp parallel for schedule(static) if(others*sw >= M4R_PARALLEL_WORDS)
+            for(i = 0; i < others; i++) {
+                GF2_WORD *row = m->m + (i < first ? i : i + found)*m->stride + wb;
+                addEntries(row + s, tables, gatherBits(row[0], mask), sw);
+            }
+        }
+        rank += found;
+    }
+    free(tables);
+    return rank;
+}
+
+GF2_MATRIX GF2_invertM4RI(const GF2_MATRIX m) {
+    assert(m != NULL);
+    assert(m->rows == m->cols);
+    size_t n = m->rows, r, words = usedWords(m);
+    GF2_MATRIX inv = NULL;
+
+    // [m | I], with I starting on a word boundary so that the inverse can be copied out by words.
+    GF2_MATRIX e = create(n, words*GF2_WORD_BITS + n);
+    if(!e) {
+        return NULL;
+    }
+    for(r = 0; r < n; r++) {
+        GF2_WORD *row = e->m + r*e->stride;
+        memcpy(row, m->m + r*m->stride, words*sizeof(GF2_WORD));
+        row[words + r / GF2_WORD_BITS] = (GF2_WORD) 1 << (r % GF2_WORD_BITS);
+    }
+
+    // Reduced, a full-rank [m | I] is [I | m^-1].
+    if(GF2_reduceM4RI(e, n, NULL) == n && (inv = create(n, n))) {
+        for(r = 0; r < n; r++) {
+            memcpy(inv->m + r*inv->stride, e->m + r*e->stride + words, words*sizeof(GF2_WORD));
+        }
+    }
+    destroy(e);
+    return inv;
+}
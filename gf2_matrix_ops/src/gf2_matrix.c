@@ -1,37 +1,59 @@
 #include "gf2_matrix.h"
+#include "gf2_simd.h"
 
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 GF2_MATRIX create(const size_t rows, const size_t cols) {
-    int row, col;
-    GF2_MATRIX m = (GF2_MATRIX) malloc(sizeof(Matrix) + rows*cols - 1);
-    if(m) {
-        m->rows = rows;
-        m->cols = cols;
-        m->m = (uint8_t*)( m + 2*sizeof(size_t));
-        for(col = 0; col < m->cols; col++) {
-            for(row = 0; row < m->rows; row++) {
-                *(m->m + col*cols + row) = 0;
-            }
-        }
+    GF2_MATRIX m = (GF2_MATRIX) malloc(sizeof(Matrix));
+    if(!m) {
+        return NULL;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Rows are padded to whole cache lines so that no two rows share a line and bulk operations
+    // can run over aligned, full-width words without a tail case. The padding costs at most
+    // 511 bits per row.
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = (cols + GF2_WORD_BITS - 1) / GF2_WORD_BITS;
+    m->stride = (m->stride + GF2_STRIDE_ALIGN - 1) / GF2_STRIDE_ALIGN * GF2_STRIDE_ALIGN;
+    if(m->stride == 0) {
+        m->stride = GF2_STRIDE_ALIGN;
     }
+
+    size_t rowBytes = m->stride*sizeof(GF2_WORD);
+    if(rows > SIZE_MAX / rowBytes) {
+        free(m);
+        return NULL;
+    }
+    size_t bytes = (rows ? rows : 1)*rowBytes;
+    m->m = (GF2_WORD*) aligned_alloc(GF2_ALIGNMENT, bytes);
+    if(!m->m) {
+        free(m);
+        return NULL;
+    }
+    memset(m->m, 0, bytes);
     return m;
 }
 
 GF2_MATRIX createIdentityMatrix(const size_t dim){
-    int i;
+    size_t i;
     GF2_MATRIX m = create(dim, dim);
-    for(i = 0; i < dim; i++){
-        *(m->m + i*dim + i) = 1;
+    if(m) {
+        for(i = 0; i < dim; i++){
+            m->m[i*m->stride + i/GF2_WORD_BITS] = (GF2_WORD) 1 << (i % GF2_WORD_BITS);
+        }
     }
     return m;
 }
+
 void destroy(GF2_MATRIX m) {
     if(m) {
+        free(m->m);
         free(m);
-        m = NULL;
     }
 }
 
@@ -39,23 +61,102 @@ GF2_ELEM getValue(const size_t row, const size_t col, const GF2_MATRIX m) {
     assert(m != NULL);
     assert(row >= 1 && row <= m->rows);
     assert(col >= 1 && col <= m->cols);
-    return *(m->m + (col-1)*m->cols + (row-1));
+    GF2_WORD w = GF2_row(row, m)[(col-1) / GF2_WORD_BITS];
+    return (GF2_ELEM) ((w >> ((col-1) % GF2_WORD_BITS)) & 0x1);
 }
 
 void setValue(const size_t row, const size_t col, const GF2_ELEM e, GF2_MATRIX m) {
     assert(m != NULL);
     assert(row >= 1 && row <= m->rows);
     assert(col >= 1 && col <= m->cols);
-    
+
     // To enforce the GF2 property, any value set in the matrix must be a 0 or 1; hence (e & 0x1).
-    *(m->m + (col-1)*m->cols + (row-1)) |= (e & 0x1); 
+    GF2_WORD *w = GF2_row(row, m) + (col-1) / GF2_WORD_BITS;
+    GF2_WORD bit = (GF2_WORD) 1 << ((col-1) % GF2_WORD_BITS);
+    *w = (e & 0x1) ? (*w | bit) : (*w & ~bit);
 }
 
-void GF2_print(GF2_MATRIX m) {
-    int row, col;
+GF2_MATRIX GF2_copy(const GF2_MATRIX m) {
+    assert(m != NULL);
+    GF2_MATRIX c = create(m->rows, m->cols);
+    if(c) {
+        memcpy(c->m, m->m, m->rows*m->stride*sizeof(GF2_WORD));
+    }
+    return c;
+}
+
+void GF2_clear(GF2_MATRIX m) {
+    assert(m != NULL);
+    memset(m->m, 0, m->rows*m->stride*sizeof(GF2_WORD));
+}
+
+int GF2_equal(const GF2_MATRIX a, const GF2_MATRIX b) {
+    assert(a != NULL && b != NULL);
+    if(a->rows != b->rows || a->cols != b->cols) {
+        return 0;
+    }
+    // Equal dimensions imply equal strides, and padding is always 0.
+    return memcmp(a->m, b->m, a->rows*a->stride*sizeof(GF2_WORD)) == 0;
+}
+
+void GF2_swapRows(const size_t r1, const size_t r2, GF2_MATRIX m) {
+    assert(m != NULL);
+    assert(r1 >= 1 && r1 <= m->rows);
+    assert(r2 >= 1 && r2 <= m->rows);
+    size_t i;
+    GF2_WORD *a = GF2_row(r1, m);
+    GF2_WORD *b = GF2_row(r2, m);
+    for(i = 0; i < m->stride; i++) {
+        GF2_WORD t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+    }
+}
+
+void GF2_addRow(const size_t dst, const size_t src, GF2_MATRIX m) {
+    assert(m != NULL);
+    assert(dst >= 1 && dst <= m->rows);
+    assert(src >= 1 && src <= m->rows);
+
+    //---- OPTIMIZATION: ----
+    // One XOR adds 64 elements, and one AVX-512 XOR adds a whole cache line of them.
+    gf2XorRow(GF2_row(dst, m), GF2_row(src, m), m->stride);
+}
+
+void GF2_randomize(const uint64_t seed, GF2_MATRIX m) {
+    assert(m != NULL);
+    size_t row, w, full = m->cols / GF2_WORD_BITS;
+    GF2_WORD tail = ((GF2_WORD) 1 << (m->cols % GF2_WORD_BITS)) - 1;
+    uint64_t state = seed;
     for(row = 0; row < m->rows; row++) {
-        for(col = 0; col < m->cols; col++) {
-            printf("%u ", *(m->m + col*m->cols + row));
+        GF2_WORD *r = m->m + row*m->stride;
+        for(w = 0; w < full + (tail != 0); w++) {
+            // splitmix64: fast, and every seed gives a well-mixed stream.
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            r[w] = z ^ (z >> 31);
+        }
+        if(tail) {
+            r[full] &= tail;
+        }
+    }
+}
+
+size_t GF2_weight(const GF2_MATRIX m) {
+    assert(m != NULL);
+    size_t i, n = m->rows*m->stride, weight = 0;
+    for(i = 0; i < n; i++) {
+        weight += (size_t) __builtin_popcountll(m->m[i]);
+    }
+    return weight;
+}
+
+void GF2_print(GF2_MATRIX m) {
+    size_t row, col;
+    for(row = 1; row <= m->rows; row++) {
+        for(col = 1; col <= m->cols; col++) {
+            printf("%u ", getValue(row, col, m));
         }
         printf("\n");
     }
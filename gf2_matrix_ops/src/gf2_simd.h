@@ -0,0 +1,104 @@
+#ifndef GF2_SIMD_H
+#define GF2_SIMD_H
+
+#include "gf2_matrix.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Row XOR kernels shared by the elimination and multiplication code. They use the widest vectors
+ * the compiler targets (AVX-512: 8 words, AVX2: 4 words per instruction) and fall back to plain
+ * word loops. Rows are only guaranteed to be aligned at their first word, and the kernels are
+ * usually called from the middle of a row, so loads and stores are unaligned.
+ */
+
+/**
+ * dst = dst + src over 'words' words.
+ */
+static inline void gf2XorRow(GF2_WORD *dst, const GF2_WORD *src, size_t words) {
+    size_t j = 0;
+#if defined(__AVX512F__)
+    for(; j + 8 <= words; j += 8) {
+        __m512i d = _mm512_loadu_si512((const void*) (dst + j));
+        __m512i s = _mm512_loadu_si512((const void*) (src + j));
+        _mm512_storeu_si512((void*) (dst + j), _mm512_xor_si512(d, s));
+    }
+#elif defined(__AVX2__)
+    for(; j + 4 <= words; j += 4) {
+        __m256i d = _mm256_loadu_si256((const __m256i*) (dst + j));
+        __m256i s = _mm256_loadu_si256((const __m256i*) (src + j));
+        _mm256_storeu_si256((__m256i*) (dst + j), _mm256_xor_si256(d, s));
+    }
+#endif
+    for(; j < words; j++) {
+        dst[j] ^= src[j];
+    }
+}
+
+/**
+ * dst = a + b over 'words' words.
+ */
+static inline void gf2XorRows2(GF2_WORD *dst, const GF2_WORD *a, const GF2_WORD *b,
+                               size_t words) {
+    size_t j = 0;
+#if defined(__AVX512F__)
+    for(; j + 8 <= words; j += 8) {
+        __m512i x = _mm512_loadu_si512((const void*) (a + j));
+        __m512i y = _mm512_loadu_si512((const void*) (b + j));
+        _mm512_storeu_si512((void*) (dst + j), _mm512_xor_si512(x, y));
+    }
+#elif defined(__AVX2__)
+    for(; j + 4 <= words; j += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (a + j));
+        __m256i y = _mm256_loadu_si256((const __m256i*) (b + j));
+        _mm256_storeu_si256((__m256i*) (dst + j), _mm256_xor_si256(x, y));
+    }
+#endif
+    for(; j < words; j++) {
+        dst[j] = a[j] ^ b[j];
+    }
+}
+
+/**
+ * dst = dst + t[0] + ... + t[7] over 'words' words. The row is loaded and stored once, and the
+ * 8 sources are combined with ternary-logic XORs where AVX-512 has them (3 inputs per instruction).
+ */
+static inline void gf2XorRows8(GF2_WORD *dst, const GF2_WORD *const t[8], size_t words) {
+    size_t j = 0;
+#if defined(__AVX512F__)
+    for(; j + 8 <= words; j += 8) {
+        __m512i x = _mm512_loadu_si512((const void*) (dst + j));
+        x = _mm512_ternarylogic_epi64(x, _mm512_loadu_si512((const void*) (t[0] + j)),
+                                      _mm512_loadu_si512((const void*) (t[1] + j)), 0x96);
+        x = _mm512_ternarylogic_epi64(x, _mm512_loadu_si512((const void*) (t[2] + j)),
+                                      _mm512_loadu_si512((const void*) (t[3] + j)), 0x96);
+        x = _mm512_ternarylogic_epi64(x, _mm512_loadu_si512((const void*) (t[4] + j)),
+                                      _mm512_loadu_si512((const void*) (t[5] + j)), 0x96);
+        x = _mm512_ternarylogic_epi64(x, _mm512_loadu_si512((const void*) (t[6] + j)),
+                                      _mm512_loadu_si512((const void*) (t[7] + j)), 0x96);
+        _mm512_storeu_si512((void*) (dst + j), x);
+    }
+#elif defined(__AVX2__)
+    for(; j + 4 <= words; j += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (dst + j));
+        __m256i y = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (t[0] + j)),
+                                     _mm256_loadu_si256((const __m256i*) (t[1] + j)));
+        __m256i z = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (t[2] + j)),
+                                     _mm256_loadu_si256((const __m256i*) (t[3] + j)));
+        x = _mm256_xor_si256(x, _mm256_xor_si256(y, z));
+        y = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (t[4] + j)),
+                             _mm256_loadu_si256((const __m256i*) (t[5] + j)));
+        z = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (t[6] + j)),
+                             _mm256_loadu_si256((const __m256i*) (t[7] + j)));
+        x = _mm256_xor_si256(x, _mm256_xor_si256(y, z));
+        _mm256_storeu_si256((__m256i*) (dst + j), x);
+    }
+#endif
+    for(; j < words; j++) {
+        dst[j] ^= t[0][j] ^ t[1][j] ^ t[2][j] ^ t[3][j] ^ t[4][j] ^ t[5][j] ^ t[6][j] ^ t[7][j];
+    }
+}
+
+#endif // GF2_SIMD_H
@@ -0,0 +1,135 @@
+#include "gf2_solve.h"
+
+#include "gf2_arith.h"
+#include "gf2_m4r.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/**
+ * Reads the nullspace off a matrix in reduced row echelon form: each free column f gives the
+ * basis vector with a 1 at f and, for every pivot row i, the element (i, f) at row i's pivot.
+ * @param[in] r the reduced matrix; only its first n columns are used.
+ * @param[in] n the columns of the coefficient matrix.
+ * @param[in] rank the rank.
+ * @param[in] pivots the pivot columns of the first 'rank' rows (counting from 1).
+ * @return the (n - rank) x n basis, or NULL if memory ran out.
+ */
+static GF2_MATRIX basisFromRref(const GF2_MATRIX r, size_t n, size_t rank, const size_t *pivots) {
+    size_t i, f, w, k = 0;
+    GF2_MATRIX basis = create(n - rank, n);
+    GF2_MATRIX t = GF2_transpose(r);
+    char *isPivot = (char*) calloc(n + 1, 1);
+    if(!basis || !t || !isPivot) {
+        destroy(basis);
+        basis = NULL;
+        goto done;
+    }
+    for(i = 0; i < rank; i++) {
+        isPivot[pivots[i] - 1] = 1;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Column f of r is row f of its transpose, so the pivot rows that have a 1 in column f are
+    // found by walking the set bits of one packed row instead of testing every row of r.
+    for(f = 0; f < n; f++) {
+        if(isPivot[f]) {
+            continue;
+        }
+        GF2_WORD *v = basis->m + k++*basis->stride;
+        const GF2_WORD *col = t->m + f*t->stride;
+        v[f / GF2_WORD_BITS] |= (GF2_WORD) 1 << (f % GF2_WORD_BITS);
+        for(w = 0; w*GF2_WORD_BITS < rank; w++) {
+            GF2_WORD x;
+            for(x = col[w]; x; x &= x - 1) {
+                size_t p = pivots[w*GF2_WORD_BITS + __builtin_ctzll(x)] - 1;
+                v[p / GF2_WORD_BITS] |= (GF2_WORD) 1 << (p % GF2_WORD_BITS);
+            }
+        }
+    }
+
+done:
+    destroy(t);
+    free(isPivot);
+    return basis;
+}
+
+size_t GF2_rref(GF2_MATRIX m, size_t *pivots) {
+    return GF2_reduceM4RI(m, m->cols, pivots);
+}
+
+GF2_MATRIX GF2_nullspace(const GF2_MATRIX a) {
+    assert(a != NULL);
+    size_t rank;
+    GF2_MATRIX basis = NULL;
+    GF2_MATRIX e = GF2_copy(a);
+    size_t *pivots = (size_t*) malloc((MIN(a->rows, a->cols) + 1)*sizeof(size_t));
+    if(e && pivots && (rank = GF2_rref(e, pivots)) != SIZE_MAX) {
+        basis = basisFromRref(e, a->cols, rank, pivots);
+    }
+    destroy(e);
+    free(pivots);
+    return basis;
+}
+
+GF2_STATUS GF2_solve(const GF2_MATRIX a, const GF2_MATRIX b, GF2_SOLUTION *s) {
+    assert(a != NULL && b != NULL && s != NULL);
+    assert(b->rows == 1 && b->cols == a->rows);
+    size_t i, rank, words = (a->cols + GF2_WORD_BITS - 1) / GF2_WORD_BITS;
+    size_t bcol = words*GF2_WORD_BITS;
+    GF2_STATUS status = GF2_NO_MEMORY;
+    memset(s, 0, sizeof(*s));
+
+    // [A | b], with b starting on a word boundary so that A can be copied in by words.
+    GF2_MATRIX e = create(a->rows, bcol + 1);
+    size_t *pivots = (size_t*) malloc((MIN(a->rows, a->cols) + 1)*sizeof(size_t));
+    if(!e || !pivots) {
+        goto done;
+    }
+    for(i = 0; i < a->rows; i++) {
+        GF2_WORD *row = e->m + i*e->stride;
+        memcpy(row, a->m + i*a->stride, words*sizeof(GF2_WORD));
+        row[words] = (b->m[i / GF2_WORD_BITS] >> (i % GF2_WORD_BITS)) & 1;
+    }
+    if((rank = GF2_reduceM4RI(e, a->cols, pivots)) == SIZE_MAX ||
+       !(s->nullspace = basisFromRref(e, a->cols, rank, pivots))) {
+        goto done;
+    }
+    s->rank = rank;
+
+    // Reduced rows past the rank are zero in A, so a 1 in b there means 0 = 1.
+    status = GF2_SOLVED;
+    for(i = rank; i < e->rows; i++) {
+        status = e->m[i*e->stride + words] ? GF2_INCONSISTENT : status;
+    }
+    if(status == GF2_SOLVED) {
+        if(!(s->x = create(1, a->cols))) {
+            status = GF2_NO_MEMORY;
+            goto done;
+        }
+        for(i = 0; i < rank; i++) {
+            size_t p = pivots[i] - 1;
+            s->x->m[p / GF2_WORD_BITS] |= (e->m[i*e->stride + words] & 1) << (p % GF2_WORD_BITS);
+        }
+    }
+
+done:
+    if(status == GF2_NO_MEMORY) {
+        GF2_freeSolution(s);
+    }
+    destroy(e);
+    free(pivots);
+    return status;
+}
+
+void GF2_freeSolution(GF2_SOLUTION *s) {
+    if(s) {
+        destroy(s->x);
+        destroy(s->nullspace);
+        s->x = NULL;
+        s->nullspace = NULL;
+    }
+}
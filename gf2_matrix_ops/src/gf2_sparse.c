@@ -0,0 +1,809 @@
+#include "gf2_sparse.h"
+
+#include "gf2_solve.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Products are spread over threads (with OpenMP) once they touch this many words.
+#define SPARSE_PARALLEL_WORDS (1 << 16)
+
+// Pruned matrices with at most this many elements are reduced densely by GF2_nullspace(); that
+// is faster than Block Lanczos up to about 4096 x 4096 (see gf2_matrix_bench).
+#define SPARSE_DENSE_BITS ((size_t) 1 << 24)
+
+// Block Lanczos gains about 63.2 dimensions per iteration. Iterating this many times past that
+// means it has broken down; it is then restarted from another random block.
+#define LANCZOS_SLACK 32
+#define LANCZOS_ATTEMPTS 3
+
+#define BLOCK GF2_WORD_BITS                       // Vectors in a Block Lanczos block.
+#define BYTE_TABLES (GF2_WORD_BITS / 8)           // Byte tables covering one word.
+
+// Block Lanczos' work grows with the columns, but it only returns one block of vectors, so
+// pruning keeps at most this many more columns than rows.
+#define SPARSE_EXCESS_COLS (2*BLOCK)
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/**
+ * Allocates a sparse matrix with room for its ones; row offsets start at 0.
+ * @param[in] rows the number of rows.
+ * @param[in] cols the number of columns.
+ * @param[in] ones the number of ones.
+ * @return a GF2_SPARSE pointer, or NULL if it could not be allocated or is too large.
+ */
+static GF2_SPARSE allocSparse(const size_t rows, const size_t cols, const size_t ones) {
+    if(rows > (size_t) UINT32_MAX + 1 || cols > (size_t) UINT32_MAX + 1) {
+        return NULL;
+    }
+    GF2_SPARSE a = (GF2_SPARSE) malloc(sizeof(SparseMatrix));
+    if(!a) {
+        return NULL;
+    }
+    a->rows = rows;
+    a->cols = cols;
+    a->ones = ones;
+    a->start = (size_t*) calloc(rows + 1, sizeof(size_t));
+    a->col = (uint32_t*) malloc((ones ? ones : 1)*sizeof(uint32_t));
+    if(!a->start || !a->col) {
+        GF2_sparseDestroy(a);
+        return NULL;
+    }
+    return a;
+}
+
+static int compareCols(const void *x, const void *y) {
+    uint32_t a = *(const uint32_t*) x, b = *(const uint32_t*) y;
+    return (a > b) - (a < b);
+}
+
+GF2_SPARSE GF2_sparseCreate(const size_t rows, const size_t cols, const size_t count,
+                            const size_t *row, const size_t *col) {
+    assert(count == 0 || (row != NULL && col != NULL));
+    size_t i, j, k;
+    GF2_SPARSE a = allocSparse(rows, cols, count);
+    if(!a) {
+        return NULL;
+    }
+
+    // Counting sort by row: start[i + 1] counts row i, and after the prefix sums start[i] is
+    // where row i goes. Placing each 1 advances start[i] to the end of the row, which the
+    // memmove turns back into the start of the next row.
+    for(k = 0; k < count; k++) {
+        assert(row[k] >= 1 && row[k] <= rows);
+        assert(col[k] >= 1 && col[k] <= cols);
+        a->start[row[k]]++;
+    }
+    for(i = 0; i < rows; i++) {
+        a->start[i + 1] += a->start[i];
+    }
+    for(k = 0; k < count; k++) {
+        a->col[a->start[row[k] - 1]++] = (uint32_t) (col[k] - 1);
+    }
+    memmove(a->start + 1, a->start, rows*sizeof(size_t));
+    a->start[0] = 0;
+
+    // Sort each row and drop pairs of equal columns, compacting the rows as they shrink.
+    for(i = 0, k = 0; i < rows; i++) {
+        size_t begin = a->start[i], end = a->start[i + 1];
+        qsort(a->col + begin, end - begin, sizeof(uint32_t), compareCols);
+        a->start[i] = k;
+        for(j = begin; j < end; j++) {
+            if(j + 1 < end && a->col[j] == a->col[j + 1]) {
+                j++;
+            } else {
+                a->col[k++] = a->col[j];
+            }
+        }
+    }
+    a->start[rows] = k;
+    a->ones = k;
+    if(k < count) {
+        uint32_t *shrunk = (uint32_t*) realloc(a->col, (k ? k : 1)*sizeof(uint32_t));
+        a->col = shrunk ? shrunk : a->col;
+    }
+    return a;
+}
+
+GF2_SPARSE GF2_sparseFromDense(const GF2_MATRIX m) {
+    assert(m != NULL);
+    size_t i, w, k = 0, words = (m->cols + GF2_WORD_BITS - 1) / GF2_WORD_BITS;
+    GF2_SPARSE a = allocSparse(m->rows, m->cols, GF2_weight(m));
+    if(!a) {
+        return NULL;
+    }
+    for(i = 0; i < m->rows; i++) {
+        const GF2_WORD *row = m->m + i*m->stride;
+        for(w = 0; w < words; w++) {
+            GF2_WORD x;
+            for(x = row[w]; x; x &= x - 1) {
+                a->col[k++] = (uint32_t) (w*GF2_WORD_BITS + __builtin_ctzll(x));
+            }
+        }
+        a->start[i + 1] = k;
+    }
+    return a;
+}
+
+GF2_MATRIX GF2_sparseToDense(const GF2_SPARSE a) {
+    assert(a != NULL);
+    size_t i, k;
+    GF2_MATRIX m = create(a->rows, a->cols);
+    if(!m) {
+        return NULL;
+    }
+    for(i = 0; i < a->rows; i++) {
+        GF2_WORD *row = m->m + i*m->stride;
+        for(k = a->start[i]; k < a->start[i + 1]; k++) {
+            row[a->col[k] / GF2_WORD_BITS] |= (GF2_WORD) 1 << (a->col[k] % GF2_WORD_BITS);
+        }
+    }
+    return m;
+}
+
+GF2_SPARSE GF2_sparseTranspose(const GF2_SPARSE a) {
+    assert(a != NULL);
+    size_t i, k;
+    GF2_SPARSE t = allocSparse(a->cols, a->rows, a->ones);
+    if(!t) {
+        return NULL;
+    }
+
+    // Counting sort by column, as in GF2_sparseCreate(). Rows are visited in order, so every
+    // row of the transpose comes out sorted.
+    for(k = 0; k < a->ones; k++) {
+        t->start[a->col[k] + 1]++;
+    }
+    for(i = 0; i < t->rows; i++) {
+        t->start[i + 1] += t->start[i];
+    }
+    for(i = 0; i < a->rows; i++) {
+        for(k = a->start[i]; k < a->start[i + 1]; k++) {
+            t->col[t->start[a->col[k]]++] = (uint32_t) i;
+        }
+    }
+    memmove(t->start + 1, t->start, t->rows*sizeof(size_t));
+    t->start[0] = 0;
+    return t;
+}
+
+void GF2_sparseDestroy(GF2_SPARSE a) {
+    if(a) {
+        free(a->start);
+        free(a->col);
+        free(a);
+    }
+}
+
+GF2_ELEM GF2_sparseGetValue(const size_t row, const size_t col, const GF2_SPARSE a) {
+    assert(a != NULL);
+    assert(row >= 1 && row <= a->rows);
+    assert(col >= 1 && col <= a->cols);
+    size_t lo = a->start[row - 1], hi = a->start[row];
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(a->col[mid] < col - 1) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (GF2_ELEM) (lo < a->start[row] && a->col[lo] == col - 1);
+}
+
+GF2_MATRIX GF2_sparseMulVec(const GF2_SPARSE a, const GF2_MATRIX x) {
+    assert(a != NULL && x != NULL);
+    assert(x->rows == 1 && x->cols == a->cols);
+    size_t w;
+    GF2_MATRIX y = create(1, a->rows);
+    if(!y) {
+        return NULL;
+    }
+
+    //---- OPTIMIZATION: ----
+    // Element i of the product is the parity of the elements of x at the ones of row i, so the
+    // cost is one bit lookup per 1 instead of a pass over every column. Each word of y is built
+    // from its 64 rows and stored once, so threads never write the same word.
+    #pragma omp parallel for schedule(static) if(a->ones >= SPARSE_PARALLEL_WORDS)
+    for(w = 0; w < (a->rows + GF2_WORD_BITS - 1) / GF2_WORD_BITS; w++) {
+        size_t i, k, last = MIN(a->rows, (w + 1)*GF2_WORD_BITS);
+        GF2_WORD word = 0;
+        for(i = w*GF2_WORD_BITS; i < last; i++) {
+            GF2_WORD parity = 0;
+            for(k = a->start[i]; k < a->start[i + 1]; k++) {
+                parity ^= x->m[a->col[k] / GF2_WORD_BITS] >> (a->col[k] % GF2_WORD_BITS);
+            }
+            word |= (parity & 1) << (i % GF2_WORD_BITS);
+        }
+        y->m[w] = word;
+    }
+    return y;
+}
+
+void GF2_sparseMulBlock(const GF2_SPARSE a, const GF2_WORD *x, GF2_WORD *y) {
+    assert(a != NULL && x != NULL && y != NULL);
+    size_t i;
+
+    //---- OPTIMIZATION: ----
+    // 64 vectors are multiplied at the cost of one: each 1 of a row selects a whole word of x.
+    // Rows write only their own word of y, so they are split over threads as they are.
+    #pragma omp parallel for schedule(static) if(a->ones >= SPARSE_PARALLEL_WORDS)
+    for(i = 0; i < a->rows; i++) {
+        size_t k;
+        GF2_WORD acc = 0;
+        for(k = a->start[i]; k < a->start[i + 1]; k++) {
+            acc ^= x[a->col[k]];
+        }
+        y[i] = acc;
+    }
+}
+
+//---- Nullspace ----
+
+/**
+ * Removes a column while pruning: every row it was in loses a 1.
+ * @param[in] j the column.
+ * @param[in] t the transpose of the matrix, whose row j lists the rows of column j.
+ * @param[in,out] weight the ones of each row in columns that are still in.
+ * @param[in,out] single rows whose weight drops to 1 are pushed here.
+ * @param[in,out] top the number of rows in 'single'.
+ * @param[in,out] newCol removed columns are marked UINT32_MAX.
+ * @return the number of rows whose weight dropped to 0.
+ */
+static size_t removeColumn(size_t j, const GF2_SPARSE t, size_t *weight, size_t *single,
+                           size_t *top, uint32_t *newCol) {
+    size_t k, emptied = 0;
+    newCol[j] = UINT32_MAX;
+    for(k = t->start[j]; k < t->start[j + 1]; k++) {
+        size_t w = --weight[t->col[k]];
+        if(w == 1) {
+            single[(*top)++] = t->col[k];
+        }
+        emptied += w == 0;
+    }
+    return emptied;
+}
+
+/**
+ * Shrinks a matrix without changing the nullspace vectors it has to offer, as in the first steps
+ * of structured Gaussian elimination:
+ * - a row with a single 1 forces that column to 0, so the column and the row are removed;
+ * - columns in excess of the rows by more than SPARSE_EXCESS_COLS are set to 0, leaving a
+ *   nullspace that is still larger than GF2_SPARSE_NULLSPACE_MAX.
+ * Both are repeated until neither applies, and empty rows are dropped. Vectors in the nullspace
+ * of the result, with the removed columns set to 0, are in the nullspace of a.
+ * @param[in] a the matrix.
+ * @param[out] colMap receives, for each column of the result, its column in a (counting from 0);
+ * room for a->cols columns.
+ * @return the pruned matrix, or NULL if memory ran out.
+ */
+static GF2_SPARSE prune(const GF2_SPARSE a, uint32_t *colMap) {
+    size_t i, j, k, top = 0, rows = 0, cols = a->cols, ones = 0, last = a->cols;
+    GF2_SPARSE p = NULL, t = GF2_sparseTranspose(a);
+    size_t *weight = (size_t*) malloc((a->rows ? a->rows : 1)*sizeof(size_t));
+    size_t *single = (size_t*) malloc((a->rows ? a->rows : 1)*sizeof(size_t));
+    uint32_t *newCol = (uint32_t*) calloc(a->cols ? a->cols : 1, sizeof(uint32_t));
+    if(!t || !weight || !single || !newCol) {
+        goto done;
+    }
+
+    // A row's weight drops to 1 at most once, so 'single' never holds more than every row.
+    for(i = 0; i < a->rows; i++) {
+        weight[i] = a->start[i + 1] - a->start[i];
+        rows += weight[i] != 0;
+        if(weight[i] == 1) {
+            single[top++] = i;
+        }
+    }
+    for(;;) {
+        while(top) {
+            i = single[--top];
+            if(weight[i] != 1) {
+                continue;
+            }
+            for(k = a->start[i]; newCol[a->col[k]] == UINT32_MAX; k++);
+            rows -= removeColumn(a->col[k], t, weight, single, &top, newCol);
+            cols--;
+        }
+        if(cols <= rows + SPARSE_EXCESS_COLS) {
+            break;
+        }
+        while(cols > rows + SPARSE_EXCESS_COLS) {
+            if(newCol[--last] != UINT32_MAX) {
+                rows -= removeColumn(last, t, weight, single, &top, newCol);
+                cols--;
+            }
+        }
+    }
+
+    for(j = 0, cols = 0; j < a->cols; j++) {
+        if(newCol[j] != UINT32_MAX) {
+            colMap[cols] = (uint32_t) j;
+            newCol[j] = (uint32_t) cols++;
+        }
+    }
+    for(i = 0; i < a->rows; i++) {
+        ones += weight[i];
+    }
+    if(!(p = allocSparse(rows, cols, ones))) {
+        goto done;
+    }
+    for(i = 0, rows = 0, ones = 0; i < a->rows; i++) {
+        if(weight[i] == 0) {
+            continue;
+        }
+        for(k = a->start[i]; k < a->start[i + 1]; k++) {
+            if(newCol[a->col[k]] != UINT32_MAX) {
+                p->col[ones++] = newCol[a->col[k]];
+            }
+        }
+        p->start[++rows] = ones;
+    }
+
+done:
+    GF2_sparseDestroy(t);
+    free(weight);
+    free(single);
+    free(newCol);
+    return p;
+}
+
+/**
+ * Finds the nullspace of a matrix of at most 128 columns but any number of rows. Rows are reduced
+ * one at a time against an echelon basis of the rows before them and kept only if something is
+ * left, so at most 128 rows are ever stored.
+ * @param[in] lo the first 64 columns of each row.
+ * @param[in] hi the next 64 columns of each row.
+ * @param[in] rows the number of rows.
+ * @param[in] cols the number of columns {cols <= 128}
+ * @return a basis as by GF2_nullspace(), or NULL if memory ran out.
+ */
+static GF2_MATRIX narrowNullspace(const GF2_WORD *lo, const GF2_WORD *hi, size_t rows,
+                                  size_t cols) {
+    GF2_WORD basis[2*GF2_WORD_BITS][2];
+    size_t pivotRow[2*GF2_WORD_BITS] = { 0 };
+    size_t i, rank = 0;
+    for(i = 0; i < rows && rank < cols; i++) {
+        GF2_WORD r0 = lo[i], r1 = hi[i];
+        while(r0 | r1) {
+            size_t p = r0 ? (size_t) __builtin_ctzll(r0)
+                          : (size_t) (GF2_WORD_BITS + __builtin_ctzll(r1));
+            if(!pivotRow[p]) {
+                basis[rank][0] = r0;
+                basis[rank][1] = r1;
+                pivotRow[p] = ++rank;
+                break;
+            }
+            r0 ^= basis[pivotRow[p] - 1][0];
+            r1 ^= basis[pivotRow[p] - 1][1];
+        }
+    }
+    if(rank == 0) {
+        return createIdentityMatrix(cols);
+    }
+
+    GF2_MATRIX m = create(rank, cols), null = NULL;
+    if(m) {
+        for(i = 0; i < rank; i++) {
+            m->m[i*m->stride] = basis[i][0];
+            m->m[i*m->stride + 1] = basis[i][1];
+        }
+        null = GF2_nullspace(m);
+    }
+    destroy(m);
+    return null;
+}
+
+/**
+ * Fills a byte table for each byte of a word with every sum of the corresponding 8 rows of a
+ * 64 x 64 matrix, so that a 1 x 64 vector times the matrix takes 8 lookups.
+ * @param[in] m the 64 rows of the matrix.
+ * @param[out] t entry e of table b is the sum of rows 8b + i for every bit i set in e.
+ */
+static void buildTables(const GF2_WORD m[BLOCK], GF2_WORD t[BYTE_TABLES][256]) {
+    size_t b, e;
+    for(b = 0; b < BYTE_TABLES; b++) {
+        t[b][0] = 0;
+        for(e = 1; e < 256; e++) {
+            t[b][e] = t[b][e & (e - 1)] ^ m[8*b + __builtin_ctzll(e)];
+        }
+    }
+}
+
+/**
+ * @param[in] t the tables of a 64 x 64 matrix, from buildTables().
+ * @param[in] x a 1 x 64 vector.
+ * @return x times the matrix.
+ */
+static inline GF2_WORD lookup(GF2_WORD t[BYTE_TABLES][256], GF2_WORD x) {
+    return t[0][x & 0xFF] ^ t[1][(x >> 8) & 0xFF] ^ t[2][(x >> 16) & 0xFF] ^
+           t[3][(x >> 24) & 0xFF] ^ t[4][(x >> 32) & 0xFF] ^ t[5][(x >> 40) & 0xFF] ^
+           t[6][(x >> 48) & 0xFF] ^ t[7][x >> 56];
+}
+
+/**
+ * Multiplies two 64 x 64 matrices: c = a * b. c may be a or b.
+ */
+static void mul64(const GF2_WORD a[BLOCK], const GF2_WORD b[BLOCK], GF2_WORD c[BLOCK]) {
+    GF2_WORD t[BYTE_TABLES][256], r[BLOCK];
+    size_t i;
+    buildTables(b, t);
+    for(i = 0; i < BLOCK; i++) {
+        r[i] = lookup(t, a[i]);
+    }
+    memcpy(c, r, sizeof(r));
+}
+
+/**
+ * Computes the 64 x 64 inner product c = x^T y of two n x 64 blocks.
+ * @param[in] x n words; word j is row j of the block.
+ * @param[in] y n words.
+ * @param[in] n the rows of the blocks.
+ * @param[out] c row r is the sum of y[j] over the words x[j] with bit r set.
+ */
+static void innerProduct(const GF2_WORD *x, const GF2_WORD *y, size_t n, GF2_WORD c[BLOCK]) {
+    GF2_WORD t[BYTE_TABLES][256];
+    size_t j, b, e, i;
+    memset(t, 0, sizeof(t));
+
+    //---- OPTIMIZATION: ----
+    // Rather than testing 64 bits of x[j], y[j] is added to one bucket per byte of x[j]. Bucket
+    // e of byte b then holds the sum of the y[j] whose byte b is e, and row 8b + i of c is the
+    // sum of the buckets with bit i set: 8 XORs per row of the blocks instead of 64.
+    for(j = 0; j < n; j++) {
+        GF2_WORD w = x[j], v = y[j];
+        for(b = 0; b < BYTE_TABLES; b++) {
+            t[b][(w >> 8*b) & 0xFF] ^= v;
+        }
+    }
+    for(b = 0; b < BYTE_TABLES; b++) {
+        for(i = 0; i < 8; i++) {
+            GF2_WORD acc = 0;
+            for(e = 0; e < 256; e++) {
+                acc ^= (e >> i & 1) ? t[b][e] : 0;
+            }
+            c[8*b + i] = acc;
+        }
+    }
+}
+
+/**
+ * Chooses which vectors of the block V_i to keep, and the inverse of V_i^T B V_i restricted to
+ * them (Montgomery, Figure 1). Vectors left out last time are tried first, so that the two
+ * choices together cover all 64 vectors, as the recurrence needs.
+ * @param[in] t V_i^T B V_i.
+ * @param[in] last the vectors chosen in the previous iteration, as a bit mask.
+ * @param[out] winv receives W_i^-1, which is 0 outside the chosen rows and columns.
+ * @param[out] chosen receives the chosen vectors S_i as a bit mask.
+ * @return 1, or 0 if no valid choice exists and the iteration has broken down.
+ */
+static int chooseVectors(const GF2_WORD t[BLOCK], GF2_WORD last, GF2_WORD winv[BLOCK],
+                         GF2_WORD *chosen) {
+    GF2_WORD m[BLOCK][2], swap[2];
+    size_t order[BLOCK], i, j, k = 0;
+    for(i = 0; i < BLOCK; i++) {
+        m[i][0] = t[i];
+        m[i][1] = (GF2_WORD) 1 << i;
+        if(!(last >> i & 1)) {
+            order[k++] = i;
+        }
+    }
+    for(i = 0; i < BLOCK; i++) {
+        if(last >> i & 1) {
+            order[k++] = i;
+        }
+    }
+
+    // Gauss-Jordan on [t | I] in the chosen column order. A column without a pivot in t is
+    // dropped from S_i, and the matching row of I is cleared instead.
+    *chosen = 0;
+    for(i = 0; i < BLOCK; i++) {
+        size_t c = order[i];
+        GF2_WORD bit = (GF2_WORD) 1 << c;
+        int half = 0;
+        for(j = i; j < BLOCK && !(m[order[j]][0] & bit); j++);
+        if(j == BLOCK) {
+            half = 1;
+            for(j = i; j < BLOCK && !(m[order[j]][1] & bit); j++);
+            if(j == BLOCK) {
+                return 0;
+            }
+        }
+        memcpy(swap, m[order[j]], sizeof(swap));
+        memcpy(m[order[j]], m[c], sizeof(swap));
+        memcpy(m[c], swap, sizeof(swap));
+        for(k = 0; k < BLOCK; k++) {
+            if(k != c && (m[k][half] & bit)) {
+                m[k][0] ^= m[c][0];
+                m[k][1] ^= m[c][1];
+            }
+        }
+        if(half) {
+            m[c][0] = m[c][1] = 0;
+        } else {
+            *chosen |= bit;
+        }
+    }
+    if((*chosen | last) != ~(GF2_WORD) 0) {
+        return 0;
+    }
+    for(i = 0; i < BLOCK; i++) {
+        winv[i] = m[i][1];
+    }
+    return 1;
+}
+
+static GF2_WORD nextRandom(uint64_t *state) {
+    // splitmix64, as in GF2_randomize().
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Runs Montgomery's Block Lanczos iteration on the symmetric matrix B = A^T A, where A has n
+ * columns. For a random n x 64 block Y it solves B X = B Y, so that the columns of X - Y are in
+ * the nullspace of B, up to the last block V_m that the iteration stops on.
+ * @param[in] a A.
+ * @param[in] at A^T.
+ * @param[in] seed the seed of Y.
+ * @param[out] x receives X - Y; n words.
+ * @param[out] v receives V_m; n words.
+ * @return 1, or 0 if memory ran out or the iteration broke down.
+ */
+static int blockLanczos(const GF2_SPARSE a, const GF2_SPARSE at, const uint64_t seed,
+                        GF2_WORD *x, GF2_WORD *v) {
+    size_t n = a->cols, j, r, iter, limit = n / (BLOCK - 1) + LANCZOS_SLACK;
+    uint64_t state = seed;
+    int ok = 0;
+    GF2_WORD vAv[BLOCK], vAAv[BLOCK], winv[BLOCK], d[BLOCK], e[BLOCK], f[BLOCK], s[BLOCK];
+    GF2_WORD vAv1[BLOCK] = { 0 }, vAAv1[BLOCK] = { 0 }, winv1[BLOCK] = { 0 };
+    GF2_WORD winv2[BLOCK] = { 0 }, chosen, chosen1 = ~(GF2_WORD) 0, anyF;
+    GF2_WORD (*tables)[BYTE_TABLES][256] = malloc(4*sizeof(*tables));
+    GF2_WORD *v0 = (GF2_WORD*) malloc(n*sizeof(GF2_WORD));
+    GF2_WORD *vi = (GF2_WORD*) malloc(n*sizeof(GF2_WORD));
+    GF2_WORD *v1 = (GF2_WORD*) calloc(n, sizeof(GF2_WORD));
+    GF2_WORD *v2 = (GF2_WORD*) calloc(n, sizeof(GF2_WORD));
+    GF2_WORD *av = (GF2_WORD*) malloc(n*sizeof(GF2_WORD));
+    GF2_WORD *tmp = (GF2_WORD*) malloc((a->rows ? a->rows : 1)*sizeof(GF2_WORD));
+    if(!tables || !v0 || !vi || !v1 || !v2 || !av || !tmp) {
+        goto done;
+    }
+
+    // V_0 = B Y.
+    for(j = 0; j < n; j++) {
+        x[j] = nextRandom(&state);
+    }
+    GF2_sparseMulBlock(a, x, tmp);
+    GF2_sparseMulBlock(at, tmp, v0);
+    memcpy(vi, v0, n*sizeof(GF2_WORD));
+    memset(x, 0, n*sizeof(GF2_WORD));
+
+    //---- OPTIMIZATION: ----
+    // Each iteration handles 64 dimensions at once: B is applied to 64 vectors with one pass
+    // over the ones of A and A^T, and only the last three blocks are kept, so memory is a few
+    // words per column on top of A. The 64 x 64 coefficients are applied with byte tables.
+    for(iter = 0; ; iter++) {
+        if(iter > limit) {
+            goto done;
+        }
+        GF2_sparseMulBlock(a, vi, tmp);
+        GF2_sparseMulBlock(at, tmp, av);
+        innerProduct(vi, av, n, vAv);
+        innerProduct(av, av, n, vAAv);
+        for(r = 0; r < BLOCK && !vAv[r]; r++);
+        if(r == BLOCK) {
+            break;
+        }
+        if(!chooseVectors(vAv, chosen1, winv, &chosen)) {
+            goto done;
+        }
+
+        // X += V_i W_i^-1 V_i^T V_0
+        innerProduct(vi, v0, n, s);
+        mul64(winv, s, s);
+        buildTables(s, tables[3]);
+
+        // V_{i+1} = B V_i S_i S_i^T + V_i D_{i+1} + V_{i-1} E_{i+1} + V_{i-2} F_{i+1}, where
+        //   D_{i+1} = I + W_i^-1 (V_i^T B^2 V_i S_i S_i^T + V_i^T B V_i)
+        //   E_{i+1} = W_{i-1}^-1 V_i^T B V_i S_i S_i^T
+        //   F_{i+1} = W_{i-2}^-1 (I + V_{i-1}^T B V_{i-1} W_{i-1}^-1)
+        //             (V_{i-1}^T B^2 V_{i-1} S_{i-1} S_{i-1}^T + V_{i-1}^T B V_{i-1}) S_i S_i^T
+        for(r = 0; r < BLOCK; r++) {
+            s[r] = (vAAv[r] & chosen) ^ vAv[r];
+        }
+        mul64(winv, s, d);
+        for(r = 0; r < BLOCK; r++) {
+            d[r] ^= (GF2_WORD) 1 << r;
+            s[r] = vAv[r] & chosen;
+        }
+        mul64(winv1, s, e);
+        mul64(vAv1, winv1, f);
+        for(r = 0; r < BLOCK; r++) {
+            f[r] ^= (GF2_WORD) 1 << r;
+            s[r] = (vAAv1[r] & chosen1) ^ vAv1[r];
+        }
+        mul64(f, s, f);
+        mul64(winv2, f, f);
+        for(r = 0, anyF = 0; r < BLOCK; r++) {
+            f[r] &= chosen;
+            anyF |= f[r];
+        }
+        buildTables(d, tables[0]);
+        buildTables(e, tables[1]);
+        buildTables(f, tables[2]);
+
+        //---- OPTIMIZATION: ----
+        // X and V_{i+1} are updated in one pass, so V_i is read once, and F_{i+1}, which is 0 in
+        // about 40% of iterations, is skipped when it is: this halves the time outside the
+        // sparse products.
+        #pragma omp parallel for schedule(static) if(n >= SPARSE_PARALLEL_WORDS)
+        for(j = 0; j < n; j++) {
+            GF2_WORD w = vi[j];
+            x[j] ^= lookup(tables[3], w);
+            v2[j] = (av[j] & chosen) ^ lookup(tables[0], w) ^ lookup(tables[1], v1[j]) ^
+                    (anyF ? lookup(tables[2], v2[j]) : 0);
+        }
+
+        GF2_WORD *next = v2;
+        v2 = v1;
+        v1 = vi;
+        vi = next;
+        memcpy(winv2, winv1, sizeof(winv1));
+        memcpy(winv1, winv, sizeof(winv));
+        memcpy(vAv1, vAv, sizeof(vAv));
+        memcpy(vAAv1, vAAv, sizeof(vAAv));
+        chosen1 = chosen;
+    }
+
+    // Y was drawn from 'seed'; draw it again rather than keeping another block.
+    state = seed;
+    for(j = 0; j < n; j++) {
+        x[j] ^= nextRandom(&state);
+    }
+    memcpy(v, vi, n*sizeof(GF2_WORD));
+    ok = 1;
+
+done:
+    free(tables);
+    free(v0);
+    free(vi);
+    free(v1);
+    free(v2);
+    free(av);
+    free(tmp);
+    return ok;
+}
+
+/**
+ * Finds nullspace vectors of a large pruned matrix with Block Lanczos. The iteration gives 128
+ * vectors X - Y and V_m that are only in the nullspace of A^T A; the combinations of them that A
+ * maps to 0 are found with narrowNullspace() and reduced to independent vectors.
+ * @param[in] a the matrix.
+ * @param[in] seed the seed of the random start.
+ * @return up to GF2_SPARSE_NULLSPACE_MAX independent nullspace vectors, or NULL on failure.
+ */
+static GF2_MATRIX lanczosNullspace(const GF2_SPARSE a, const uint64_t seed) {
+    size_t n = a->cols, i, j, rank;
+    GF2_MATRIX combos = NULL, found = NULL, null = NULL;
+    GF2_SPARSE at = GF2_sparseTranspose(a);
+    GF2_WORD *x = (GF2_WORD*) malloc(n*sizeof(GF2_WORD));
+    GF2_WORD *v = (GF2_WORD*) malloc(n*sizeof(GF2_WORD));
+    GF2_WORD *ax = (GF2_WORD*) malloc((a->rows ? a->rows : 1)*sizeof(GF2_WORD));
+    GF2_WORD *av = (GF2_WORD*) malloc((a->rows ? a->rows : 1)*sizeof(GF2_WORD));
+    if(!at || !x || !v || !ax || !av || !blockLanczos(a, at, seed, x, v)) {
+        goto done;
+    }
+    GF2_sparseMulBlock(a, x, ax);
+    GF2_sparseMulBlock(a, v, av);
+    if(!(combos = narrowNullspace(ax, av, a->rows, 2*BLOCK)) ||
+       !(found = create(combos->rows, n))) {
+        goto done;
+    }
+    for(j = 0; j < n; j++) {
+        for(i = 0; i < combos->rows; i++) {
+            const GF2_WORD *c = combos->m + i*combos->stride;
+            GF2_WORD bit = (GF2_WORD) (__builtin_popcountll((x[j] & c[0]) ^ (v[j] & c[1])) & 1);
+            found->m[i*found->stride + j / GF2_WORD_BITS] |= bit << (j % GF2_WORD_BITS);
+        }
+    }
+    if((rank = GF2_rref(found, NULL)) == SIZE_MAX ||
+       !(null = create(MIN(rank, GF2_SPARSE_NULLSPACE_MAX), n))) {
+        goto done;
+    }
+    memcpy(null->m, found->m, null->rows*null->stride*sizeof(GF2_WORD));
+
+done:
+    GF2_sparseDestroy(at);
+    free(x);
+    free(v);
+    free(ax);
+    free(av);
+    destroy(combos);
+    destroy(found);
+    return null;
+}
+
+/**
+ * Finds nullspace vectors of a pruned matrix, by the cheapest method for its shape.
+ * @param[in] p the pruned matrix.
+ * @param[in] seed the seed for Block Lanczos.
+ * @return independent nullspace vectors of p, or NULL on failure.
+ */
+static GF2_MATRIX prunedNullspace(const GF2_SPARSE p, const uint64_t seed) {
+    size_t j, attempt;
+    GF2_MATRIX null = NULL;
+
+    // Nothing left to satisfy: every column that is left is free.
+    if(p->rows == 0) {
+        null = create(MIN(p->cols, GF2_SPARSE_NULLSPACE_MAX), p->cols);
+        for(j = 0; null && j < null->rows; j++) {
+            null->m[j*null->stride + j / GF2_WORD_BITS] = (GF2_WORD) 1 << (j % GF2_WORD_BITS);
+        }
+        return null;
+    }
+
+    // Too few columns for Block Lanczos: multiplying by the identity packs each row into two
+    // words for narrowNullspace().
+    if(p->cols <= 2*BLOCK) {
+        GF2_WORD unit[2][2*BLOCK] = { { 0 } };
+        GF2_WORD *lo = (GF2_WORD*) malloc(p->rows*sizeof(GF2_WORD));
+        GF2_WORD *hi = (GF2_WORD*) malloc(p->rows*sizeof(GF2_WORD));
+        for(j = 0; j < p->cols; j++) {
+            unit[j / BLOCK][j] = (GF2_WORD) 1 << (j % BLOCK);
+        }
+        if(lo && hi) {
+            GF2_sparseMulBlock(p, unit[0], lo);
+            GF2_sparseMulBlock(p, unit[1], hi);
+            null = narrowNullspace(lo, hi, p->rows, p->cols);
+        }
+        free(lo);
+        free(hi);
+        return null;
+    }
+
+    if(p->rows*p->cols <= SPARSE_DENSE_BITS) {
+        GF2_MATRIX d = GF2_sparseToDense(p);
+        null = d ? GF2_nullspace(d) : NULL;
+        destroy(d);
+        return null;
+    }
+
+    for(attempt = 0; !null && attempt < LANCZOS_ATTEMPTS; attempt++) {
+        null = lanczosNullspace(p, seed + attempt);
+    }
+    return null;
+}
+
+GF2_MATRIX GF2_sparseNullspace(const GF2_SPARSE a, const uint64_t seed) {
+    assert(a != NULL);
+    size_t i, w;
+    GF2_MATRIX found = NULL, null = NULL;
+    GF2_SPARSE p = NULL;
+    uint32_t *colMap = (uint32_t*) malloc((a->cols ? a->cols : 1)*sizeof(uint32_t));
+    if(!colMap || !(p = prune(a, colMap)) || !(found = prunedNullspace(p, seed)) ||
+       !(null = create(MIN(found->rows, GF2_SPARSE_NULLSPACE_MAX), a->cols))) {
+        goto done;
+    }
+
+    // Put the columns that survived pruning back where they were in a.
+    for(i = 0; i < null->rows; i++) {
+        const GF2_WORD *row = found->m + i*found->stride;
+        for(w = 0; w*GF2_WORD_BITS < found->cols; w++) {
+            GF2_WORD x;
+            for(x = row[w]; x; x &= x - 1) {
+                uint32_t c = colMap[w*GF2_WORD_BITS + __builtin_ctzll(x)];
+                null->m[i*null->stride + c / GF2_WORD_BITS] |= (GF2_WORD) 1 << (c % GF2_WORD_BITS);
+            }
+        }
+    }
+
+done:
+    free(colMap);
+    GF2_sparseDestroy(p);
+    destroy(found);
+    return null;
+}
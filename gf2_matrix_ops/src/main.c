@@ -21,6 +21,12 @@ int main(int argc, char**argv) {
     GF2_MATRIX n = createIdentityMatrix(10);
     GF2_print(n);
 
+    printf("\nAdd row 1 to row 10 and swap rows 2 and 3\n\n");
+    GF2_addRow(10,1,n);
+    GF2_swapRows(2,3,n);
+    GF2_print(n);
+    printf("\nOnes in the matrix: %zu\n", GF2_weight(n));
+
     destroy(m);
     destroy(n);
 }
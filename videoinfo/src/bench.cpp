@@ -0,0 +1,457 @@
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef VIDEOINFO_X86
+#include <x86intrin.h>
+#endif
+
+#include "frame_geometry.h"
+#include "frame_source.h"
+#include "psnr.h"
+#include "ssd.h"
+#include "worker_pool.h"
+
+using namespace std;
+
+#define VERSION "0.1.0"
+
+namespace po = boost::program_options;
+
+namespace {
+
+/**
+ * Named frame size.
+ */
+typedef struct Resolution {
+    const char* name;
+    uint width, height;
+} Resolution;
+
+const Resolution RESOLUTIONS[] = {
+    { "480p", 854, 480 },
+    { "720p", 1280, 720 },
+    { "1080p", 1920, 1080 },
+    { "2160p", 3840, 2160 },
+    { "4320p", 7680, 4320 },
+};
+
+typedef struct BenchConfig {
+    vector<Resolution> resolutions;
+    vector<string> samplings;    // "4:4:4", "4:2:2", ...
+    vector<uint> bitDepths;
+    vector<SimdLevel> levels;
+    vector<uint> threads;
+    double minSeconds;           // minimum measured time per configuration
+    size_t workingSetBytes;      // synthetic reference + test bytes per configuration
+    string tmpfs;                // directory for file-backed runs, empty for in-memory
+} BenchConfig;
+
+/**
+ * One measured configuration.
+ */
+typedef struct BenchResult {
+    string sampling;
+    const char* resolution;
+    uint width, height, bitDepth;
+    size_t bytesPerFrame;
+    SimdLevel level;
+    uint threads;
+    size_t frames;               // frames scored
+    double seconds;
+    double cycles;               // TSC cycles elapsed, 0 if unavailable
+} BenchResult;
+
+/**
+ * Small, fast generator for synthetic samples (xorshift64*).
+ */
+class Noise {
+public:
+    explicit Noise(uint64_t seed) : state_(seed | 1) {}
+
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 2685821657736338717ULL;
+    }
+
+private:
+    uint64_t state_;
+};
+
+/**
+ * Fills a reference/test frame pair: the reference is a diagonal gradient with texture noise, the
+ * test is the reference plus small coding-like errors, clipped to the sample range.
+ */
+void synthesize(const FrameGeometry& g, uint64_t seed, uint8_t* ref, uint8_t* tst) {
+    Noise noise(seed);
+    const int maxSample = MAX_I(g.bitDepth);
+    const int scale = maxSample / 255;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        const PlaneGeometry& pg = g.planes[p];
+        for (uint y = 0; y < pg.height; y++) {
+            uint8_t* r = ref + pg.offset + y * pg.stride;
+            uint8_t* t = tst + pg.offset + y * pg.stride;
+            for (uint x = 0; x < pg.width; x++) {
+                uint64_t n = noise.next();
+                int base = (int) (((x + y + seed) & 0xff) * scale) + (int) (n & 15) * scale;
+                int err = (int) ((n >> 8) % 9) - 4;
+                int a = std::min(base, maxSample);
+                int b = std::max(0, std::min(a + err * scale, maxSample));
+                if (g.bytesPerSample == 1) {
+                    r[x] = (uint8_t) a;
+                    t[x] = (uint8_t) b;
+                } else {
+                    ((uint16_t*) r)[x] = (uint16_t) a;
+                    ((uint16_t*) t)[x] = (uint16_t) b;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Frames held in memory, served without I/O.
+ */
+class MemoryFrameSource : public FrameSource {
+public:
+    MemoryFrameSource(vector<uint8_t>&& frames, size_t bytesPerFrame)
+            : frames_(std::move(frames)), bytesPerFrame_(bytesPerFrame) {}
+
+    size_t frameCount() const override { return frames_.size() / bytesPerFrame_; }
+    const uint8_t* acquire(size_t f) override { return frames_.data() + f * bytesPerFrame_; }
+    void release(size_t) override {}
+
+private:
+    vector<uint8_t> frames_;
+    size_t bytesPerFrame_;
+};
+
+uint64_t readCycles() {
+#ifdef VIDEOINFO_X86
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Generates the synthetic clip for one configuration and opens it either in memory or, with
+ * --tmpfs, through the same mmap path the CLI uses.
+ */
+void openClip(const BenchConfig& c, const FrameGeometry& g, size_t frames,
+              unique_ptr<FrameSource>* ref, unique_ptr<FrameSource>* tst) {
+    vector<uint8_t> r(frames * g.bytesPerFrame), t(frames * g.bytesPerFrame);
+    for (size_t f = 0; f < frames; f++) {
+        synthesize(g, f + 1, &r[f * g.bytesPerFrame], &t[f * g.bytesPerFrame]);
+    }
+    if (c.tmpfs.empty()) {
+        ref->reset(new MemoryFrameSource(std::move(r), g.bytesPerFrame));
+        tst->reset(new MemoryFrameSource(std::move(t), g.bytesPerFrame));
+        return;
+    }
+
+    string paths[2] = { c.tmpfs + "/videoinfo_bench_ref.yuv",
+                        c.tmpfs + "/videoinfo_bench_tst.yuv" };
+    const vector<uint8_t>* data[2] = { &r, &t };
+    for (int i = 0; i < 2; i++) {
+        ofstream out(paths[i], ios::binary | ios::trunc);
+        out.write((const char*) data[i]->data(), data[i]->size());
+        if (!out) {
+            cerr << "ERROR: failed to write file: " << paths[i] << endl;
+            exit(1);
+        }
+    }
+    ref->reset(new MappedFrameSource(paths[0], g.bytesPerFrame));
+    tst->reset(new MappedFrameSource(paths[1], g.bytesPerFrame));
+    // The mappings keep the data alive; the names are not needed any more.
+    remove(paths[0].c_str());
+    remove(paths[1].c_str());
+}
+
+template <class S>
+void benchSampling(const BenchConfig& c, const string& sampling, vector<BenchResult>* results) {
+    for (const Resolution& res : c.resolutions) {
+        for (uint bitDepth : c.bitDepths) {
+            FrameGeometry g = S::geometry(res.width, res.height, bitDepth);
+
+            // Enough distinct frames that the clip does not sit in cache between passes.
+            size_t frames = std::max((size_t) 2, c.workingSetBytes / (2 * g.bytesPerFrame));
+            unique_ptr<FrameSource> ref, tst;
+            openClip(c, g, frames, &ref, &tst);
+
+            // Scalar SSDs, which every other kernel has to match before it is timed.
+            vector<FrameSSE> expected(frames);
+            setSimdLevel(SIMD_SCALAR);
+            for (size_t f = 0; f < frames; f++) {
+                expected[f] = frameSSE<S>(g, ref->acquire(f), tst->acquire(f));
+                ref->release(f);
+                tst->release(f);
+            }
+
+            for (uint threads : c.threads) {
+                WorkerPool pool(threads);
+                for (SimdLevel level : c.levels) {
+                    setSimdLevel(level);
+                    cerr << "  " << sampling << " " << res.name << " " << bitDepth << "-bit "
+                            << simdLevelName(level) << " x" << pool.size() << endl;
+
+                    vector<FrameSSE> sse(frames);
+                    auto pass = [&]() {
+                        pool.parallelFor(frames, [&](size_t f) {
+                            sse[f] = frameSSE<S>(g, ref->acquire(f), tst->acquire(f));
+                            ref->release(f);
+                            tst->release(f);
+                        });
+                    };
+
+                    pass(); // warm-up: page faults, worker wake-up
+                    for (size_t f = 0; f < frames; f++) {
+                        for (int p = 0; p < NUM_PLANES; p++) {
+                            if (sse[f].sse[p] != expected[f].sse[p]) {
+                                cerr << "ERROR: " << simdLevelName(level) << " SSD of frame " << f
+                                        << " plane " << p << " is " << sse[f].sse[p]
+                                        << ", scalar is " << expected[f].sse[p] << endl;
+                                exit(1);
+                            }
+                        }
+                    }
+
+                    size_t scored = 0;
+                    auto start = chrono::steady_clock::now();
+                    uint64_t startCycles = readCycles();
+                    chrono::duration<double> elapsed(0);
+                    do {
+                        pass();
+                        scored += frames;
+                        elapsed = chrono::steady_clock::now() - start;
+                    } while (elapsed.count() < c.minSeconds);
+                    uint64_t cycles = readCycles() - startCycles;
+
+                    BenchResult r = { sampling, res.name, res.width, res.height, bitDepth,
+                                      g.bytesPerFrame, level, pool.size(), scored,
+                                      elapsed.count(), (double) cycles };
+                    results->push_back(r);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Writes the results as one JSON document. Throughput counts reference plus test bytes; cycles
+ * per pixel are TSC cycles summed over all threads per luma pixel.
+ */
+void writeJSON(ostream& out, const vector<BenchResult>& results) {
+    string cpu;
+    ifstream cpuinfo("/proc/cpuinfo");
+    for (string line; getline(cpuinfo, line);) {
+        if (line.compare(0, 10, "model name") == 0) {
+            cpu = line.substr(line.find(':') + 2);
+            break;
+        }
+    }
+
+    out << "{\"version\":\"" << VERSION << "\",\"compiler\":\"" << __VERSION__ << "\",\"cpu\":\""
+            << cpu << "\",\"cores\":" << thread::hardware_concurrency() << ",\"best_simd\":\""
+            << simdLevelName(detectSimdLevel()) << "\",\"results\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        double fps = r.frames / r.seconds;
+        double gbps = 2.0 * r.bytesPerFrame * fps / 1e9;
+        double pixels = (double) r.frames * r.width * r.height;
+
+        char line[512];
+        snprintf(line, sizeof(line),
+                 "%s\n{\"sampling\":\"%s\",\"resolution\":\"%s\",\"width\":%u,\"height\":%u,"
+                 "\"bitdepth\":%u,\"simd\":\"%s\",\"threads\":%u,\"frames\":%zu,"
+                 "\"seconds\":%.6f,\"fps\":%.3f,\"gbps\":%.3f,",
+                 i ? "," : "", r.sampling.c_str(), r.resolution, r.width, r.height, r.bitDepth,
+                 simdLevelName(r.level), r.threads, r.frames, r.seconds, fps, gbps);
+        out << line;
+        if (r.cycles > 0) {
+            snprintf(line, sizeof(line), "\"cycles_per_pixel\":%.4f}",
+                     r.cycles * r.threads / pixels);
+        } else {
+            snprintf(line, sizeof(line), "\"cycles_per_pixel\":null}");
+        }
+        out << line;
+    }
+    out << "\n]}" << endl;
+}
+
+/**
+ * Splits a comma-separated option value.
+ */
+vector<string> splitList(const string& list) {
+    vector<string> items;
+    istringstream iss(list);
+    for (string item; getline(iss, item, ',');) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/**
+ * Parses one item of a numeric list option, exiting with an error unless it is a number.
+ */
+uint parseNumber(const string& item, const char* option) {
+    if (regex_match(item, regex("[0-9]+"))) {
+        try {
+            unsigned long value = stoul(item);
+            if (value <= UINT_MAX) {
+                return (uint) value;
+            }
+        } catch (out_of_range&) {
+        }
+    }
+    cerr << "ERROR: --" << option << " must be a comma-separated list of numbers: " << item
+            << endl;
+    exit(-1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig c;
+    string resolutions, samplings, bitDepths, levels, threads, out;
+    double workingSetMiB;
+
+    po::options_description desc("Options");
+    desc.add_options()
+            ("help", "Print help messages")
+            ("resolutions", po::value<string>(&resolutions)->default_value("480p,720p,1080p,2160p,4320p"), "Comma-separated frame sizes")
+            ("sampling",    po::value<string>(&samplings)->default_value("4:4:4,4:2:2,4:2:0"), "Comma-separated chroma subsamplings")
+            ("bitdepth",    po::value<string>(&bitDepths)->default_value("8,10"), "Comma-separated bit depths (8 to 16)")
+            ("simd",        po::value<string>(&levels), "Comma-separated SSD kernels (default: every level this CPU supports)")
+            ("threads",     po::value<string>(&threads), "Comma-separated thread counts (default: 1 and one per core)")
+            ("min-time",    po::value<double>(&c.minSeconds)->default_value(0.5), "Minimum measured seconds per configuration")
+            ("working-set", po::value<double>(&workingSetMiB)->default_value(256), "MiB of synthetic reference + test frames per configuration")
+            ("tmpfs",       po::value<string>(&c.tmpfs), "Write the synthetic clips to this directory (e.g. /dev/shm) and score them through mmap")
+            ("out,o",       po::value<string>(&out), "Write the JSON report to this file (default: stdout)");
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help")) {
+            cout << endl << "USAGE: videoinfo_bench [options]" << endl;
+            cout << endl << "    Measures SSD/PSNR throughput on synthetic video and reports JSON."
+                    << endl;
+            cout << desc << endl << "v" << VERSION << endl;
+            return 0;
+        }
+        po::notify(vm);
+    } catch (po::error& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        return 1;
+    }
+
+    for (const string& name : splitList(resolutions)) {
+        size_t i = 0;
+        while (i < sizeof(RESOLUTIONS) / sizeof(RESOLUTIONS[0]) && name != RESOLUTIONS[i].name) {
+            i++;
+        }
+        if (i == sizeof(RESOLUTIONS) / sizeof(RESOLUTIONS[0])) {
+            cerr << "ERROR: unknown resolution: " << name << endl;
+            exit(-1);
+        }
+        c.resolutions.push_back(RESOLUTIONS[i]);
+    }
+
+    c.samplings = splitList(samplings);
+    for (const string& s : c.samplings) {
+        uint xShift, yShift;
+        if (s.size() != 5 || !chromaShifts(s[0] - '0', s[2] - '0', s[4] - '0', &xShift, &yShift)) {
+            cerr << "ERROR: unsupported sub-sampling mode: " << s << endl;
+            exit(-1);
+        }
+    }
+
+    for (const string& d : splitList(bitDepths)) {
+        uint depth = parseNumber(d, "bitdepth");
+        if (depth < 8 || depth > 16) {
+            cerr << "ERROR: bit depth must be between 8 and 16!" << endl;
+            exit(-1);
+        }
+        c.bitDepths.push_back(depth);
+    }
+
+    SimdLevel best = detectSimdLevel();
+    if (levels.empty()) {
+        for (int level = SIMD_SCALAR; level <= best; level++) {
+            c.levels.push_back((SimdLevel) level);
+        }
+    }
+    for (const string& name : splitList(levels)) {
+        int level = 0;
+        while (level < NUM_SIMD_LEVELS && name != simdLevelName((SimdLevel) level)) {
+            level++;
+        }
+        if (level == NUM_SIMD_LEVELS) {
+            cerr << "ERROR: unknown SIMD level: " << name << endl;
+            exit(-1);
+        }
+        if (level > best) {
+            cerr << "WARNING: " << name << " not supported, skipping" << endl;
+            continue;
+        }
+        c.levels.push_back((SimdLevel) level);
+    }
+
+    if (threads.empty()) {
+        c.threads.push_back(1);
+        if (thread::hardware_concurrency() > 1) {
+            c.threads.push_back(thread::hardware_concurrency());
+        }
+    }
+    for (const string& t : splitList(threads)) {
+        c.threads.push_back(parseNumber(t, "threads"));
+    }
+
+    c.workingSetBytes = (size_t) (workingSetMiB * (1 << 20));
+
+    vector<BenchResult> results;
+    for (const string& s : c.samplings) {
+        uint xShift, yShift;
+        chromaShifts(s[0] - '0', s[2] - '0', s[4] - '0', &xShift, &yShift);
+        if (xShift == 0 && yShift == 0) {
+            benchSampling<YUV444>(c, s, &results);
+        } else if (xShift == 1 && yShift == 0) {
+            benchSampling<YUV422>(c, s, &results);
+        } else if (xShift == 1 && yShift == 1) {
+            benchSampling<YUV420>(c, s, &results);
+        } else if (xShift == 2 && yShift == 0) {
+            benchSampling<YUV411>(c, s, &results);
+        } else if (xShift == 0 && yShift == 1) {
+            benchSampling<YUV440>(c, s, &results);
+        }
+    }
+
+    if (out.empty()) {
+        writeJSON(cout, results);
+    } else {
+        ofstream file(out);
+        writeJSON(file, results);
+        if (!file) {
+            cerr << "ERROR: failed to write file: " << out << endl;
+            exit(1);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "container_reader.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "videoinfo_error.h"
+
+using namespace std;
+
+ContainerFrameSource::ContainerFrameSource(const string& path, size_t bytesPerFrame,
+                                           unsigned buffers, const FrameSampling& sampling)
+        : file_(path), bytesPerFrame_(bytesPerFrame), sampling_(sampling),
+          codec_(CODEC_NONE) {
+    ContainerHeader header;
+    ContainerFooter footer;
+    if (file_.size() < sizeof(header) + sizeof(footer)) {
+        throw VideoInfoError("truncated frame container: " + path);
+    }
+    memcpy(&header, file_.data(), sizeof(header));
+    memcpy(&footer, file_.data() + file_.size() - sizeof(footer), sizeof(footer));
+    if (memcmp(header.magic, CONTAINER_MAGIC, sizeof(header.magic)) != 0 ||
+            memcmp(footer.magic, CONTAINER_INDEX_MAGIC, sizeof(footer.magic)) != 0) {
+        throw VideoInfoError("not a complete frame container: " + path);
+    }
+    if (header.bytesPerFrame != bytesPerFrame) {
+        throw VideoInfoError("frame container holds frames of " +
+                             to_string(header.bytesPerFrame) + " bytes, expected " +
+                             to_string(bytesPerFrame) + ": " + path);
+    }
+    codec_ = (FrameCodec) header.codec;
+
+    // The index and every block it names must lie between the header and the footer.
+    uint64_t end = file_.size() - sizeof(footer);
+    if (footer.indexOffset < sizeof(header) || footer.indexOffset > end ||
+            footer.frames > (end - footer.indexOffset) / sizeof(ContainerBlock)) {
+        throw VideoInfoError("corrupt frame container index: " + path);
+    }
+    index_.resize(footer.frames);
+    memcpy(index_.data(), file_.data() + footer.indexOffset,
+           index_.size() * sizeof(ContainerBlock));
+    for (const ContainerBlock& b : index_) {
+        if (b.offset < sizeof(header) || b.offset > footer.indexOffset ||
+                b.length > footer.indexOffset - b.offset) {
+            throw VideoInfoError("corrupt frame container index: " + path);
+        }
+    }
+
+    slots_.resize(buffers ? buffers : 1);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        slots_[i].buffer.resize(bytesPerFrame_);
+        slots_[i].decompressor.reset(new FrameDecompressor(codec_));
+        slots_[i].next = i;
+    }
+}
+
+bool ContainerFrameSource::isContainer(const string& path) {
+    char magic[sizeof(CONTAINER_MAGIC)];
+    ifstream in(path, ios::binary);
+    return in.read(magic, sizeof(magic)) && memcmp(magic, CONTAINER_MAGIC, sizeof(magic)) == 0;
+}
+
+const uint8_t* ContainerFrameSource::acquire(size_t f) {
+    Slot& slot = slots_[f % slots_.size()];
+    {
+        // Wait for the frame that used this slot one lap earlier to be released.
+        unique_lock<mutex> lock(mutex_);
+        slotFree_.wait(lock, [&slot, f] { return slot.next == f; });
+    }
+    const ContainerBlock& b = index_[sampling_.frame(f)];
+    slot.decompressor->decompress(file_.data() + b.offset, b.length, slot.buffer.data(),
+                                  bytesPerFrame_);
+    return slot.buffer.data();
+}
+
+void ContainerFrameSource::release(size_t f) {
+    Slot& slot = slots_[f % slots_.size()];
+    {
+        lock_guard<mutex> lock(mutex_);
+        slot.next = f + slots_.size();
+    }
+    slotFree_.notify_all();
+}
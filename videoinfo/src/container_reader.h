@@ -0,0 +1,69 @@
+#ifndef VIDEOINFO_CONTAINER_READER_H
+#define VIDEOINFO_CONTAINER_READER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "frame_container.h"
+#include "frame_source.h"
+#include "mapped_file.h"
+
+/**
+ * Frames read from a compressed container (see frame_container.h).
+ *
+ * The container is memory-mapped and each acquire() decompresses its frame on the calling thread,
+ * so decompression spreads over the scoring workers and runs as parallel as the scoring does; the
+ * disk only delivers the compressed bytes. Frame f is decompressed into slot f % buffers, which is
+ * only reused once the frame that previously occupied it has been released.
+ */
+class ContainerFrameSource : public FrameSource {
+public:
+    /**
+     * Opens the container and loads its index. Throws VideoInfoError on failure, or if the frames
+     * in the container are not bytesPerFrame long.
+     * @param[in] path the container file.
+     * @param[in] bytesPerFrame size of one raw frame.
+     * @param[in] buffers number of decompressed frames that can be held at once.
+     * @param[in] sampling the frames to serve; only these are decompressed.
+     */
+    ContainerFrameSource(const std::string& path, size_t bytesPerFrame, unsigned buffers,
+                         const FrameSampling& sampling = FrameSampling());
+
+    /**
+     * @param[in] path a file.
+     * @return true if the file starts like a frame container.
+     */
+    static bool isContainer(const std::string& path);
+
+    size_t frameCount() const override { return sampling_.count(index_.size()); }
+    size_t maxHeldFrames() const override { return slots_.size(); }
+    const uint8_t* acquire(size_t f) override;
+    void release(size_t f) override;
+
+    /**
+     * @return the codec the container was written with.
+     */
+    FrameCodec codec() const { return codec_; }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> buffer;
+        std::unique_ptr<FrameDecompressor> decompressor;
+        size_t next;             // the only frame allowed to claim the slot next
+    };
+
+    MappedFile file_;
+    size_t bytesPerFrame_;
+    FrameSampling sampling_;
+    FrameCodec codec_;
+    std::vector<ContainerBlock> index_;
+    std::vector<Slot> slots_;
+
+    std::mutex mutex_;
+    std::condition_variable slotFree_;
+};
+
+#endif // VIDEOINFO_CONTAINER_READER_H
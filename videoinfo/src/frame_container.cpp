@@ -0,0 +1,236 @@
+#include "frame_container.h"
+
+#include <cstring>
+
+#ifdef VIDEOINFO_ZSTD
+#include <zstd.h>
+#endif
+#ifdef VIDEOINFO_LZ4
+#include <lz4.h>
+#endif
+
+#include "videoinfo_error.h"
+
+using namespace std;
+
+// Headers, index entries and footers are written as they are laid out in memory.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "frame containers are only implemented for little-endian hosts"
+#endif
+
+const char CONTAINER_MAGIC[8] = { 'V', 'I', 'F', 'R', 'A', 'M', 'E', '1' };
+const char CONTAINER_INDEX_MAGIC[8] = { 'V', 'I', 'I', 'N', 'D', 'E', 'X', '1' };
+
+namespace {
+
+const size_t CONTAINER_BUFFER_BYTES = 4 << 20;
+
+void requireCodec(FrameCodec codec) {
+    if (!codecAvailable(codec)) {
+        throw VideoInfoError(string("this build does not support ") + codecName(codec) +
+                             " compression");
+    }
+}
+
+} // namespace
+
+const char* codecName(FrameCodec codec) {
+    switch (codec) {
+    case CODEC_ZSTD:
+        return "zstd";
+    case CODEC_LZ4:
+        return "lz4";
+    default:
+        return "none";
+    }
+}
+
+bool parseCodec(const string& name, FrameCodec* codec) {
+    for (int c = CODEC_NONE; c <= CODEC_LZ4; c++) {
+        if (name == codecName((FrameCodec) c)) {
+            *codec = (FrameCodec) c;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool codecAvailable(FrameCodec codec) {
+    switch (codec) {
+    case CODEC_NONE:
+        return true;
+#ifdef VIDEOINFO_ZSTD
+    case CODEC_ZSTD:
+        return true;
+#endif
+#ifdef VIDEOINFO_LZ4
+    case CODEC_LZ4:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+FrameCompressor::FrameCompressor(FrameCodec codec, int level)
+        : codec_(codec), level_(level), context_(nullptr) {
+    requireCodec(codec);
+#ifdef VIDEOINFO_ZSTD
+    if (codec_ == CODEC_ZSTD) {
+        context_ = ZSTD_createCCtx();
+        if (!context_) {
+            throw VideoInfoError("failed to create zstd compression context");
+        }
+    }
+#endif
+}
+
+FrameCompressor::~FrameCompressor() {
+#ifdef VIDEOINFO_ZSTD
+    if (codec_ == CODEC_ZSTD) {
+        ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(context_));
+    }
+#endif
+}
+
+void FrameCompressor::compress(const uint8_t* frame, size_t length, vector<uint8_t>* block) {
+    switch (codec_) {
+#ifdef VIDEOINFO_ZSTD
+    case CODEC_ZSTD: {
+        block->resize(ZSTD_compressBound(length));
+        size_t n = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(context_), block->data(),
+                                     block->size(), frame, length, level_);
+        if (ZSTD_isError(n)) {
+            throw VideoInfoError(string("zstd compression failed: ") + ZSTD_getErrorName(n));
+        }
+        block->resize(n);
+        return;
+    }
+#endif
+#ifdef VIDEOINFO_LZ4
+    case CODEC_LZ4: {
+        if (length > (size_t) LZ4_MAX_INPUT_SIZE) {
+            throw VideoInfoError("frame too large for lz4 compression");
+        }
+        block->resize(LZ4_compressBound((int) length));
+        int n = LZ4_compress_default((const char*) frame, (char*) block->data(), (int) length,
+                                     (int) block->size());
+        if (n <= 0) {
+            throw VideoInfoError("lz4 compression failed");
+        }
+        block->resize(n);
+        return;
+    }
+#endif
+    default:
+        block->assign(frame, frame + length);
+        return;
+    }
+}
+
+FrameDecompressor::FrameDecompressor(FrameCodec codec) : codec_(codec), context_(nullptr) {
+    requireCodec(codec);
+#ifdef VIDEOINFO_ZSTD
+    if (codec_ == CODEC_ZSTD) {
+        context_ = ZSTD_createDCtx();
+        if (!context_) {
+            throw VideoInfoError("failed to create zstd decompression context");
+        }
+    }
+#endif
+}
+
+FrameDecompressor::~FrameDecompressor() {
+#ifdef VIDEOINFO_ZSTD
+    if (codec_ == CODEC_ZSTD) {
+        ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(context_));
+    }
+#endif
+}
+
+void FrameDecompressor::decompress(const uint8_t* block, size_t blockLength, uint8_t* frame,
+                                   size_t frameLength) {
+    size_t n = 0;
+    switch (codec_) {
+#ifdef VIDEOINFO_ZSTD
+    case CODEC_ZSTD:
+        n = ZSTD_decompressDCtx(static_cast<ZSTD_DCtx*>(context_), frame, frameLength, block,
+                                blockLength);
+        if (ZSTD_isError(n)) {
+            throw VideoInfoError(string("corrupt zstd frame: ") + ZSTD_getErrorName(n));
+        }
+        break;
+#endif
+#ifdef VIDEOINFO_LZ4
+    case CODEC_LZ4: {
+        int got = LZ4_decompress_safe((const char*) block, (char*) frame, (int) blockLength,
+                                      (int) frameLength);
+        if (got < 0) {
+            throw VideoInfoError("corrupt lz4 frame");
+        }
+        n = got;
+        break;
+    }
+#endif
+    default:
+        n = blockLength;
+        if (n == frameLength) {
+            memcpy(frame, block, n);
+        }
+        break;
+    }
+    if (n != frameLength) {
+        throw VideoInfoError("compressed frame holds " + to_string(n) + " bytes, expected " +
+                             to_string(frameLength));
+    }
+}
+
+ContainerWriter::ContainerWriter(const string& path, FrameCodec codec, int level,
+                                 size_t bytesPerFrame)
+        : out_(nullptr), path_(path), offset_(0) {
+    out_ = fopen(path.c_str(), "wb");
+    if (!out_) {
+        throw VideoInfoError("failed to create file: " + path);
+    }
+    setvbuf(out_, nullptr, _IOFBF, CONTAINER_BUFFER_BYTES);
+
+    ContainerHeader header;
+    memcpy(header.magic, CONTAINER_MAGIC, sizeof(header.magic));
+    header.codec = codec;
+    header.level = (uint32_t) level;
+    header.bytesPerFrame = bytesPerFrame;
+    write(&header, sizeof(header));
+}
+
+ContainerWriter::~ContainerWriter() {
+    if (out_) {
+        fclose(out_);
+    }
+}
+
+void ContainerWriter::append(const uint8_t* block, size_t length) {
+    index_.push_back(ContainerBlock{offset_, length});
+    write(block, length);
+}
+
+void ContainerWriter::finish() {
+    ContainerFooter footer;
+    footer.frames = index_.size();
+    footer.indexOffset = offset_;
+    memcpy(footer.magic, CONTAINER_INDEX_MAGIC, sizeof(footer.magic));
+    write(index_.data(), index_.size() * sizeof(ContainerBlock));
+    write(&footer, sizeof(footer));
+
+    FILE* out = out_;
+    out_ = nullptr;
+    if (fclose(out) != 0) {
+        throw VideoInfoError("failed to write file: " + path_);
+    }
+}
+
+void ContainerWriter::write(const void* data, size_t length) {
+    if (length && fwrite(data, 1, length, out_) != length) {
+        throw VideoInfoError("failed to write file: " + path_);
+    }
+    offset_ += length;
+}
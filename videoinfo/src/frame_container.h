@@ -0,0 +1,190 @@
+#ifndef VIDEOINFO_FRAME_CONTAINER_H
+#define VIDEOINFO_FRAME_CONTAINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Compressed, frame-indexed container of raw video (written by videoinfo_pack). Every frame is
+ * compressed on its own, so any frame can be located through the index and decompressed without
+ * touching its neighbours, and frames can be decompressed in parallel. All integers are
+ * little-endian:
+ *
+ *   header   "VIFRAME1", uint32 codec, uint32 level, uint64 bytes per frame
+ *   blocks   one compressed block per frame, back to back
+ *   index    uint64 block offset and uint64 block length per frame
+ *   footer   uint64 frame count, uint64 index offset, "VIINDEX1"
+ *
+ * The index sits at the end so that a container can be written in one pass from a pipe.
+ */
+
+/**
+ * Block compression used by a container.
+ */
+enum FrameCodec {
+    CODEC_NONE = 0,              // stored as is
+    CODEC_ZSTD = 1,              // zstd; needs libzstd at build time
+    CODEC_LZ4 = 2                // LZ4 block format; needs liblz4 at build time
+};
+
+/**
+ * Fixed-size start of a container.
+ */
+typedef struct ContainerHeader {
+    char magic[8];               // CONTAINER_MAGIC
+    uint32_t codec;              // FrameCodec
+    uint32_t level;              // compression level the blocks were written with
+    uint64_t bytesPerFrame;      // size of a decompressed frame
+} ContainerHeader;
+
+/**
+ * Fixed-size end of a container.
+ */
+typedef struct ContainerFooter {
+    uint64_t frames;             // number of frames, and of index entries
+    uint64_t indexOffset;        // byte offset of the index
+    char magic[8];               // CONTAINER_INDEX_MAGIC
+} ContainerFooter;
+
+/**
+ * Location of one compressed frame.
+ */
+typedef struct ContainerBlock {
+    uint64_t offset;
+    uint64_t length;
+} ContainerBlock;
+
+extern const char CONTAINER_MAGIC[8];
+extern const char CONTAINER_INDEX_MAGIC[8];
+
+/**
+ * @param[in] codec the codec.
+ * @return its name: "none", "zstd" or "lz4".
+ */
+const char* codecName(FrameCodec codec);
+
+/**
+ * Parses a codec name.
+ * @param[in] name one of the names returned by codecName().
+ * @param[out] codec the parsed codec.
+ * @return false if the name is not recognised.
+ */
+bool parseCodec(const std::string& name, FrameCodec* codec);
+
+/**
+ * @param[in] codec the codec.
+ * @return true if this build can read and write blocks with the codec.
+ */
+bool codecAvailable(FrameCodec codec);
+
+/**
+ * Compresses frames one at a time. Each instance keeps its own codec state, so use one per thread.
+ */
+class FrameCompressor {
+public:
+    /**
+     * @param[in] codec the codec; throws VideoInfoError if this build does not support it.
+     * @param[in] level compression level; 0 picks the codec's default, ignored by lz4 and none.
+     */
+    FrameCompressor(FrameCodec codec, int level);
+    ~FrameCompressor();
+
+    FrameCompressor(const FrameCompressor&) = delete;
+    FrameCompressor& operator=(const FrameCompressor&) = delete;
+
+    /**
+     * @param[in] frame the raw frame.
+     * @param[in] length its size in bytes.
+     * @param[out] block the compressed frame; resized to fit.
+     * @throws VideoInfoError if compression fails.
+     */
+    void compress(const uint8_t* frame, size_t length, std::vector<uint8_t>* block);
+
+private:
+    FrameCodec codec_;
+    int level_;
+    void* context_;              // codec-specific state, if the codec has any
+};
+
+/**
+ * Decompresses frames one at a time. Each instance keeps its own codec state, so use one per
+ * thread.
+ */
+class FrameDecompressor {
+public:
+    /**
+     * @param[in] codec the codec; throws VideoInfoError if this build does not support it.
+     */
+    explicit FrameDecompressor(FrameCodec codec);
+    ~FrameDecompressor();
+
+    FrameDecompressor(const FrameDecompressor&) = delete;
+    FrameDecompressor& operator=(const FrameDecompressor&) = delete;
+
+    /**
+     * @param[in] block the compressed frame.
+     * @param[in] blockLength its size in bytes.
+     * @param[out] frame receives the raw frame.
+     * @param[in] frameLength the size of a raw frame.
+     * @throws VideoInfoError if the block is corrupt or does not hold exactly frameLength bytes.
+     */
+    void decompress(const uint8_t* block, size_t blockLength, uint8_t* frame, size_t frameLength);
+
+private:
+    FrameCodec codec_;
+    void* context_;              // codec-specific state, if the codec has any
+};
+
+/**
+ * Writes a container front to back. Blocks are compressed by the caller, typically in parallel,
+ * and appended in frame order.
+ */
+class ContainerWriter {
+public:
+    /**
+     * Creates the file and writes the header. Throws VideoInfoError on failure.
+     * @param[in] path output file.
+     * @param[in] codec codec the blocks are compressed with.
+     * @param[in] level compression level, recorded in the header.
+     * @param[in] bytesPerFrame size of a raw frame.
+     */
+    ContainerWriter(const std::string& path, FrameCodec codec, int level, size_t bytesPerFrame);
+
+    /**
+     * Closes the file; a container that was not finish()ed has no index and cannot be read.
+     */
+    ~ContainerWriter();
+
+    ContainerWriter(const ContainerWriter&) = delete;
+    ContainerWriter& operator=(const ContainerWriter&) = delete;
+
+    /**
+     * Appends the next frame.
+     * @param[in] block the compressed frame.
+     * @param[in] length its size in bytes.
+     */
+    void append(const uint8_t* block, size_t length);
+
+    /**
+     * Writes the index and footer and closes the file. Throws VideoInfoError on failure.
+     */
+    void finish();
+
+    /**
+     * @return bytes written so far.
+     */
+    uint64_t bytesWritten() const { return offset_; }
+
+private:
+    void write(const void* data, size_t length);
+
+    FILE* out_;
+    std::string path_;
+    uint64_t offset_;
+    std::vector<ContainerBlock> index_;
+};
+
+#endif // VIDEOINFO_FRAME_CONTAINER_H
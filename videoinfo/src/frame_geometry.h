@@ -0,0 +1,219 @@
+#ifndef VIDEOINFO_FRAME_GEOMETRY_H
+#define VIDEOINFO_FRAME_GEOMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+enum Component { PLANE_Y = 0, PLANE_U = 1, PLANE_V = 2, NUM_PLANES = 3 };
+
+/**
+ * How the planes of a frame are laid out in memory (--pix-fmt).
+ */
+enum PixelFormat {
+    PIX_FMT_PLANAR,              // Y, U and V planes back to back (I420, I422, I444, ...)
+    PIX_FMT_NV12,                // Y plane, then U and V interleaved at 4:2:0
+    PIX_FMT_NV21,                // Y plane, then V and U interleaved at 4:2:0
+    PIX_FMT_P010,                // NV12 with 10-bit samples in the high bits of 16-bit words
+    PIX_FMT_YUYV,                // Y0 U Y1 V packed at 4:2:2
+    PIX_FMT_UYVY                 // U Y0 V Y1 packed at 4:2:2
+};
+
+/**
+ * Location and size of one colour plane inside a raw frame.
+ */
+typedef struct PlaneGeometry {
+    uint width, height;          // samples per row x rows
+    size_t stride;               // bytes between the start of consecutive rows
+    size_t offset;               // byte offset of the plane from the start of the frame
+    uint step;                   // samples from one sample of the plane to the next in a row
+
+    size_t samples() const { return (size_t) width * height; }
+} PlaneGeometry;
+
+/**
+ * Layout of one Y'CbCr frame. Subsampling<>::geometry() stores the three planes back to back, Y
+ * first; interleaveGeometry() rearranges them into NV12, NV21, P010, YUYV or UYVY, where planes
+ * share rows and PlaneGeometry::step and sampleShift say where each sample lives.
+ */
+typedef struct FrameGeometry {
+    PlaneGeometry planes[NUM_PLANES];
+    size_t bytesPerFrame;
+    uint chromaShiftX, chromaShiftY; // log2 of the chroma subsampling factor per axis
+    uint bitDepth;                   // significant bits per sample (8..16)
+    uint bytesPerSample;             // 1 for 8-bit video, 2 (little-endian) above that
+    PixelFormat pixelFormat;         // memory layout of the planes
+    uint sampleShift;                // bits below each sample in its word (6 for P010)
+} FrameGeometry;
+
+/**
+ * Compile-time description of a J:a:b chroma subsampling scheme, expressed as the log2 of the
+ * horizontal and vertical chroma decimation. Kernels are specialized on this type so that the
+ * chroma coordinate for luma sample (x, y) is (x >> XShift, y >> YShift) with no branching.
+ */
+template <unsigned XShift, unsigned YShift>
+struct Subsampling {
+    static const unsigned xShift = XShift;
+    static const unsigned yShift = YShift;
+
+    /**
+     * Builds the planar frame layout for this subsampling.
+     * @param[in] width luma width in samples.
+     * @param[in] height luma height in samples.
+     * @param[in] bitDepth bits per sample; depths above 8 are stored as 16-bit words.
+     * @return the frame geometry.
+     */
+    static FrameGeometry geometry(uint width, uint height, uint bitDepth = 8) {
+        FrameGeometry g;
+        g.chromaShiftX = XShift;
+        g.chromaShiftY = YShift;
+        g.bitDepth = bitDepth;
+        g.bytesPerSample = (bitDepth > 8) ? 2 : 1;
+        g.pixelFormat = PIX_FMT_PLANAR;
+        g.sampleShift = 0;
+
+        g.planes[PLANE_Y].width = width;
+        g.planes[PLANE_Y].height = height;
+        for (int p = PLANE_U; p < NUM_PLANES; p++) {
+            g.planes[p].width = (width + (1u << XShift) - 1) >> XShift;
+            g.planes[p].height = (height + (1u << YShift) - 1) >> YShift;
+        }
+
+        size_t offset = 0;
+        for (int p = 0; p < NUM_PLANES; p++) {
+            g.planes[p].stride = (size_t) g.planes[p].width * g.bytesPerSample;
+            g.planes[p].offset = offset;
+            g.planes[p].step = 1;
+            offset += g.planes[p].stride * g.planes[p].height;
+        }
+        g.bytesPerFrame = offset;
+        return g;
+    }
+};
+
+/**
+ * Rearranges a planar layout into an interleaved pixel format with the same subsampling. Samples
+ * keep their plane, width and height; only where they live changes, so results stay comparable
+ * with the planar layout of the same video.
+ * @param[in] planar the layout from Subsampling<>::geometry(): 4:2:0 for NV12, NV21 and P010
+ *            (at 10 bits for P010), 4:2:2 with an even width for YUYV and UYVY.
+ * @param[in] format the pixel format.
+ * @return the interleaved layout.
+ */
+inline FrameGeometry interleaveGeometry(const FrameGeometry& planar, PixelFormat format) {
+    FrameGeometry g = planar;
+    g.pixelFormat = format;
+    PlaneGeometry& y = g.planes[PLANE_Y];
+    PlaneGeometry& u = g.planes[PLANE_U];
+    PlaneGeometry& v = g.planes[PLANE_V];
+    size_t bps = g.bytesPerSample;
+
+    if (format == PIX_FMT_NV12 || format == PIX_FMT_NV21 || format == PIX_FMT_P010) {
+        size_t chroma = y.stride * y.height;
+        u.stride = v.stride = 2 * (size_t) u.width * bps;
+        u.step = v.step = 2;
+        u.offset = chroma + (format == PIX_FMT_NV21 ? bps : 0);
+        v.offset = chroma + (format == PIX_FMT_NV21 ? 0 : bps);
+        g.sampleShift = (format == PIX_FMT_P010) ? 16 - g.bitDepth : 0;
+    } else if (format == PIX_FMT_YUYV || format == PIX_FMT_UYVY) {
+        // Every 4-byte group holds two luma samples and one sample of each chroma plane.
+        bool yuyv = (format == PIX_FMT_YUYV);
+        y.stride = u.stride = v.stride = 2 * (size_t) y.width;
+        y.step = 2;
+        u.step = v.step = 4;
+        y.offset = yuyv ? 0 : 1;
+        u.offset = yuyv ? 1 : 0;
+        v.offset = yuyv ? 3 : 2;
+    }
+    return g;
+}
+
+/**
+ * @param[in] format the pixel format.
+ * @return its --pix-fmt name: "planar", "nv12", "nv21", "p010", "yuyv" or "uyvy".
+ */
+inline const char* pixelFormatName(PixelFormat format) {
+    static const char* names[] = { "planar", "nv12", "nv21", "p010", "yuyv", "uyvy" };
+    return names[format];
+}
+
+/**
+ * Parses a --pix-fmt argument.
+ * @param[in] name one of the names returned by pixelFormatName().
+ * @param[out] format the parsed format.
+ * @return false if the name is not recognised.
+ */
+inline bool parsePixelFormat(const std::string& name, PixelFormat* format) {
+    for (int f = PIX_FMT_PLANAR; f <= PIX_FMT_UYVY; f++) {
+        if (name == pixelFormatName((PixelFormat) f)) {
+            *format = (PixelFormat) f;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Restricts a frame layout to a luma rectangle. Planes keep their stride and only their origin and
+ * size change, so every kernel that walks a FrameGeometry scores just the rectangle while reading
+ * the frame in place. Chroma planes cover the chroma samples the rectangle touches.
+ * Only planar layouts are supported: plane origins move by x * bytesPerSample, which assumes every
+ * plane has step 1, so callers must reject --roi for interleaved pixel formats.
+ * @param[in] g the full frame layout; planar, with step 1 in every plane.
+ * @param[in] x left edge in luma samples; a multiple of the horizontal chroma decimation.
+ * @param[in] y top edge in luma samples; a multiple of the vertical chroma decimation.
+ * @param[in] width width in luma samples.
+ * @param[in] height height in luma samples.
+ * @return the cropped layout; bytesPerFrame is unchanged.
+ */
+inline FrameGeometry cropGeometry(const FrameGeometry& g, uint x, uint y, uint width,
+                                  uint height) {
+    FrameGeometry crop = g;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        uint xShift = (p == PLANE_Y) ? 0 : g.chromaShiftX;
+        uint yShift = (p == PLANE_Y) ? 0 : g.chromaShiftY;
+        uint x0 = x >> xShift, y0 = y >> yShift;
+        uint x1 = (x + width + (1u << xShift) - 1) >> xShift;
+        uint y1 = (y + height + (1u << yShift) - 1) >> yShift;
+        PlaneGeometry& pg = crop.planes[p];
+        pg.offset += y0 * pg.stride + (size_t) x0 * g.bytesPerSample;
+        pg.width = x1 - x0;
+        pg.height = y1 - y0;
+    }
+    return crop;
+}
+
+typedef Subsampling<0, 0> YUV444;
+typedef Subsampling<1, 0> YUV422;
+typedef Subsampling<1, 1> YUV420;
+typedef Subsampling<2, 0> YUV411;
+typedef Subsampling<0, 1> YUV440;
+
+/**
+ * Translates a J:a:b subsampling triple into chroma shifts.
+ * @param[in] J horizontal sampling reference.
+ * @param[in] a # of chrominance samples in the first row of J pixels.
+ * @param[in] b # of changes of chrominance samples between the first and second row.
+ * @param[out] xShift log2 of the horizontal chroma decimation.
+ * @param[out] yShift log2 of the vertical chroma decimation.
+ * @return true if the triple describes a layout with power-of-two decimation.
+ */
+inline bool chromaShifts(uint8_t J, uint8_t a, uint8_t b, uint* xShift, uint* yShift) {
+    if (J == 0 || a == 0 || J % a != 0 || (b != 0 && b != a)) {
+        return false;
+    }
+    uint factor = J / a;
+    if (factor & (factor - 1)) {
+        return false;
+    }
+    *xShift = 0;
+    while ((1u << *xShift) < factor) {
+        (*xShift)++;
+    }
+    *yShift = (b == 0) ? 1 : 0;
+    return true;
+}
+
+#endif // VIDEOINFO_FRAME_GEOMETRY_H
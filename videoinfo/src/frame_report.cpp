@@ -0,0 +1,257 @@
+#include "frame_report.h"
+
+#include <iostream>
+
+#include "videoinfo_error.h"
+
+using namespace std;
+
+namespace {
+
+const size_t REPORT_BUFFER_BYTES = 4 << 20;
+
+FILE* createReport(const string& path) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        throw VideoInfoError("failed to create file: " + path);
+    }
+    setvbuf(out, nullptr, _IOFBF, REPORT_BUFFER_BYTES);
+    return out;
+}
+
+void closeReport(FILE* out, const string& path) {
+    if (fclose(out) != 0) {
+        cerr << "ERROR: failed to write file: " << path << endl;
+    }
+}
+
+/**
+ * Writes the "tests" member of a JSON report. Test paths are emitted as given; quotes and
+ * backslashes are escaped, and control characters are written as \u00XX.
+ */
+void writeTests(FILE* out, const vector<string>& tests) {
+    fputs("\"tests\":[", out);
+    for (size_t t = 0; t < tests.size(); t++) {
+        fputs(t ? ",\"" : "\"", out);
+        for (char ch : tests[t]) {
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                fprintf(out, "\\u%04x", static_cast<unsigned char>(ch));
+                continue;
+            }
+            if (ch == '"' || ch == '\\') {
+                fputc('\\', out);
+            }
+            fputc(ch, out);
+        }
+        fputc('"', out);
+    }
+    fputs("],", out);
+}
+
+} // namespace
+
+FrameReport::FrameReport(const string& path, Format format, const FrameGeometry& g,
+                         const vector<string>& tests, unsigned metrics)
+        : out_(nullptr), path_(path), format_(format), g_(g), metrics_(metrics), first_(true),
+          multipleTests_(tests.size() > 1) {
+    out_ = createReport(path);
+
+    if (format_ == CSV) {
+        fputs(multipleTests_ ? "test,frame" : "frame", out_);
+        if (metrics_ & METRIC_PSNR) {
+            for (int p = 0; p < NUM_PLANES; p++) {
+                fprintf(out_, ",mse_%s", planeName(p));
+            }
+            for (int p = 0; p < NUM_PLANES; p++) {
+                fprintf(out_, ",psnr_%s", planeName(p));
+            }
+            fputs(",score", out_);
+        }
+        if (metrics_ & METRIC_SSIM) {
+            for (int p = 0; p < NUM_PLANES; p++) {
+                fprintf(out_, ",ssim_%s", planeName(p));
+            }
+            fputs(",ssim", out_);
+        }
+        if (metrics_ & METRIC_MSSSIM) {
+            for (int p = 0; p < NUM_PLANES; p++) {
+                fprintf(out_, ",msssim_%s", planeName(p));
+            }
+            fputs(",msssim", out_);
+        }
+        fputs("\n", out_);
+    } else {
+        fputs("{", out_);
+        if (multipleTests_) {
+            writeTests(out_, tests);
+        }
+        fprintf(out_, "\"planes\":[\"%s\",\"%s\",\"%s\"],\"frames\":[", planeName(0),
+                planeName(1), planeName(2));
+    }
+}
+
+FrameReport::~FrameReport() {
+    if (format_ == JSON) {
+        fputs("\n]}\n", out_);
+    }
+    closeReport(out_, path_);
+}
+
+void FrameReport::write(size_t test, size_t f, const FrameSSE& e, double score,
+                        const FrameSSIM& q) {
+    if (format_ == CSV) {
+        if (multipleTests_) {
+            fprintf(out_, "%zu,", test);
+        }
+        fprintf(out_, "%zu", f);
+    } else {
+        fputs(first_ ? "\n{" : ",\n{", out_);
+        if (multipleTests_) {
+            fprintf(out_, "\"test\":%zu,", test);
+        }
+        fprintf(out_, "\"frame\":%zu", f);
+    }
+
+    if (metrics_ & METRIC_PSNR) {
+        double mse[NUM_PLANES], db[NUM_PLANES];
+        for (int p = 0; p < NUM_PLANES; p++) {
+            mse[p] = planeMSE(g_, e, p);
+            db[p] = psnr(mse[p], g_.bitDepth);
+        }
+        if (format_ == CSV) {
+            fprintf(out_, ",%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f", mse[0], mse[1], mse[2], db[0],
+                    db[1], db[2], score);
+        } else {
+            fprintf(out_,
+                    ",\"mse\":[%.6f,%.6f,%.6f],\"psnr\":[%.6f,%.6f,%.6f],\"score\":%.6f",
+                    mse[0], mse[1], mse[2], db[0], db[1], db[2], score);
+        }
+    }
+    if (metrics_ & METRIC_SSIM) {
+        writeSimilarity("ssim", q.ssim);
+    }
+    if (metrics_ & METRIC_MSSSIM) {
+        writeSimilarity("msssim", q.msssim);
+    }
+
+    fputs(format_ == CSV ? "\n" : "}", out_);
+    first_ = false;
+}
+
+void FrameReport::writeSimilarity(const char* name, const double* planes) {
+    double all = planeAverage(planes);
+    if (format_ == CSV) {
+        fprintf(out_, ",%.6f,%.6f,%.6f,%.6f", planes[0], planes[1], planes[2], all);
+    } else {
+        fprintf(out_, ",\"%s\":[%.6f,%.6f,%.6f],\"%s_score\":%.6f", name, planes[0], planes[1],
+                planes[2], name, all);
+    }
+}
+
+bool FrameReport::parseFormat(const string& name, Format* format) {
+    if (name == "csv") {
+        *format = CSV;
+    } else if (name == "json") {
+        *format = JSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+TileReport::TileReport(const string& path, FrameReport::Format format, const FrameGeometry& g,
+                       const TileGrid& grid, uint x, uint y, const vector<string>& tests)
+        : out_(nullptr), path_(path), format_(format), g_(g), grid_(grid), x_(x), y_(y),
+          first_(true), multipleTests_(tests.size() > 1), mse_(grid.count() * NUM_PLANES),
+          psnr_(grid.count() * NUM_PLANES) {
+    out_ = createReport(path);
+
+    if (format_ == FrameReport::CSV) {
+        fputs(multipleTests_ ? "test,frame" : "frame", out_);
+        fputs(",tile_x,tile_y,x,y,width,height", out_);
+        for (int p = 0; p < NUM_PLANES; p++) {
+            fprintf(out_, ",mse_%s", planeName(p));
+        }
+        for (int p = 0; p < NUM_PLANES; p++) {
+            fprintf(out_, ",psnr_%s", planeName(p));
+        }
+        fputs("\n", out_);
+    } else {
+        fputs("{", out_);
+        if (multipleTests_) {
+            writeTests(out_, tests);
+        }
+        fprintf(out_,
+                "\"x\":%u,\"y\":%u,\"tile_width\":%u,\"tile_height\":%u,\"columns\":%u,"
+                "\"rows\":%u,\"planes\":[\"%s\",\"%s\",\"%s\"],\"frames\":[",
+                x_, y_, grid_.tileWidth, grid_.tileHeight, grid_.columns, grid_.rows,
+                planeName(0), planeName(1), planeName(2));
+    }
+}
+
+TileReport::~TileReport() {
+    if (format_ == FrameReport::JSON) {
+        fputs("\n]}\n", out_);
+    }
+    closeReport(out_, path_);
+}
+
+void TileReport::write(size_t test, size_t f, const uint64_t* sse) {
+    size_t tiles = grid_.count();
+    for (uint ty = 0; ty < grid_.rows; ty++) {
+        for (uint tx = 0; tx < grid_.columns; tx++) {
+            size_t t = (size_t) ty * grid_.columns + tx;
+            for (int p = 0; p < NUM_PLANES; p++) {
+                PlaneRect r = grid_.rect(g_, p, tx, ty);
+                double mse = (double) sse[t * NUM_PLANES + p] / ((size_t) r.width * r.height);
+                mse_[p * tiles + t] = mse;
+                psnr_[p * tiles + t] = psnr(mse, g_.bitDepth);
+            }
+        }
+    }
+
+    if (format_ == FrameReport::CSV) {
+        for (uint ty = 0; ty < grid_.rows; ty++) {
+            for (uint tx = 0; tx < grid_.columns; tx++) {
+                size_t t = (size_t) ty * grid_.columns + tx;
+                PlaneRect r = grid_.rect(g_, PLANE_Y, tx, ty);
+                if (multipleTests_) {
+                    fprintf(out_, "%zu,", test);
+                }
+                fprintf(out_, "%zu,%u,%u,%u,%u,%u,%u", f, tx, ty, x_ + r.x, y_ + r.y, r.width,
+                        r.height);
+                for (int p = 0; p < NUM_PLANES; p++) {
+                    fprintf(out_, ",%.6f", mse_[p * tiles + t]);
+                }
+                for (int p = 0; p < NUM_PLANES; p++) {
+                    fprintf(out_, ",%.6f", psnr_[p * tiles + t]);
+                }
+                fputs("\n", out_);
+            }
+        }
+        return;
+    }
+
+    fputs(first_ ? "\n{" : ",\n{", out_);
+    if (multipleTests_) {
+        fprintf(out_, "\"test\":%zu,", test);
+    }
+    fprintf(out_, "\"frame\":%zu", f);
+    writeGrid("mse", mse_.data());
+    writeGrid("psnr", psnr_.data());
+    fputs("}", out_);
+    first_ = false;
+}
+
+void TileReport::writeGrid(const char* name, const double* values) {
+    size_t tiles = grid_.count();
+    fprintf(out_, ",\"%s\":[", name);
+    for (int p = 0; p < NUM_PLANES; p++) {
+        fputs(p ? ",[" : "[", out_);
+        for (size_t t = 0; t < tiles; t++) {
+            fprintf(out_, t ? ",%.6f" : "%.6f", values[p * tiles + t]);
+        }
+        fputs("]", out_);
+    }
+    fputs("]", out_);
+}
@@ -0,0 +1,124 @@
+#ifndef VIDEOINFO_FRAME_REPORT_H
+#define VIDEOINFO_FRAME_REPORT_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "frame_geometry.h"
+#include "psnr.h"
+#include "ssim.h"
+#include "tiles.h"
+
+/**
+ * Streams per-frame results (per-plane MSE and PSNR, frame score, SSIM and MS-SSIM) to a CSV or
+ * JSON file. Only the metrics selected with --metrics get columns.
+ *
+ * Rows are formatted with snprintf into a large stdio buffer and reach the kernel in multi-megabyte
+ * writes, so enabling the report costs a few hundred nanoseconds per frame on the reducing thread
+ * and never blocks the scoring workers on I/O.
+ */
+class FrameReport {
+public:
+    enum Format { CSV, JSON };
+
+    /**
+     * Creates the report file and writes the header. Throws VideoInfoError on failure.
+     * @param[in] path output file.
+     * @param[in] format CSV or JSON.
+     * @param[in] g the frame layout, used to turn SSE into MSE and PSNR.
+     * @param[in] tests the test videos; with more than one, each record names its test.
+     * @param[in] metrics the Metric mask selecting which results are written.
+     */
+    FrameReport(const std::string& path, Format format, const FrameGeometry& g,
+                const std::vector<std::string>& tests, unsigned metrics);
+
+    /**
+     * Writes the trailer and closes the file.
+     */
+    ~FrameReport();
+
+    FrameReport(const FrameReport&) = delete;
+    FrameReport& operator=(const FrameReport&) = delete;
+
+    /**
+     * Appends one frame. Frames must be written in order.
+     * @param[in] test index of the test video the frame belongs to.
+     * @param[in] f the frame index.
+     * @param[in] e the per-plane SSE of the frame (METRIC_PSNR).
+     * @param[in] score the frame score in dB (METRIC_PSNR).
+     * @param[in] q the per-plane SSIM and MS-SSIM of the frame (METRIC_SSIM, METRIC_MSSSIM).
+     */
+    void write(size_t test, size_t f, const FrameSSE& e, double score, const FrameSSIM& q);
+
+    /**
+     * Parses a --format argument.
+     * @param[in] name "csv" or "json".
+     * @param[out] format the parsed format.
+     * @return false if the name is not recognised.
+     */
+    static bool parseFormat(const std::string& name, Format* format);
+
+private:
+    void writeSimilarity(const char* name, const double* planes);
+
+    FILE* out_;
+    std::string path_;
+    Format format_;
+    FrameGeometry g_;
+    unsigned metrics_;
+    bool first_;
+    bool multipleTests_;
+};
+
+/**
+ * Streams per-tile MSE and PSNR grids (--tile) to a CSV or JSON file, buffered like FrameReport.
+ * CSV has one row per tile; JSON has one record per frame holding a row-major grid per plane, ready
+ * to be drawn as a heatmap.
+ */
+class TileReport {
+public:
+    /**
+     * Creates the report file and writes the header. Throws VideoInfoError on failure.
+     * @param[in] path output file.
+     * @param[in] format CSV or JSON.
+     * @param[in] g the (possibly cropped) frame layout that is tiled.
+     * @param[in] grid the tile grid.
+     * @param[in] x luma column of the tiled area within the frame, added to tile positions.
+     * @param[in] y luma row of the tiled area within the frame, added to tile positions.
+     * @param[in] tests the test videos; with more than one, each record names its test.
+     */
+    TileReport(const std::string& path, FrameReport::Format format, const FrameGeometry& g,
+               const TileGrid& grid, uint x, uint y, const std::vector<std::string>& tests);
+
+    /**
+     * Writes the trailer and closes the file.
+     */
+    ~TileReport();
+
+    TileReport(const TileReport&) = delete;
+    TileReport& operator=(const TileReport&) = delete;
+
+    /**
+     * Appends the tiles of one frame. Frames must be written in order.
+     * @param[in] test index of the test video the frame belongs to.
+     * @param[in] f the frame index.
+     * @param[in] sse grid.count() * NUM_PLANES per-tile, per-plane SSE values from tileSSE().
+     */
+    void write(size_t test, size_t f, const uint64_t* sse);
+
+private:
+    void writeGrid(const char* name, const double* values);
+
+    FILE* out_;
+    std::string path_;
+    FrameReport::Format format_;
+    FrameGeometry g_;
+    TileGrid grid_;
+    uint x_, y_;
+    bool first_;
+    bool multipleTests_;
+    std::vector<double> mse_, psnr_;  // plane-major scratch for one frame
+};
+
+#endif // VIDEOINFO_FRAME_REPORT_H
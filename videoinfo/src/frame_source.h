@@ -0,0 +1,168 @@
+#ifndef VIDEOINFO_FRAME_SOURCE_H
+#define VIDEOINFO_FRAME_SOURCE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "frame_geometry.h"
+#include "mapped_file.h"
+
+/**
+ * Selects which frames of a video a source serves: frame f of the source is frame first + f * step
+ * of the underlying file or stream. Frames in between are never read.
+ */
+typedef struct FrameSampling {
+    size_t first = 0;
+    size_t step = 1;
+
+    /**
+     * @param[in] f a frame index of the source.
+     * @return the matching frame index of the file.
+     */
+    size_t frame(size_t f) const { return first + f * step; }
+
+    /**
+     * @param[in] frames number of complete frames in the file.
+     * @return number of frames the source serves.
+     */
+    size_t count(size_t frames) const {
+        return (frames > first) ? (frames - first + step - 1) / step : 0;
+    }
+} FrameSampling;
+
+/**
+ * Byte range [offset, offset + length) within a frame.
+ */
+typedef struct ByteRange {
+    size_t offset, length;
+} ByteRange;
+
+/**
+ * The parts of each frame a source has to read, sorted and non-overlapping. Bytes outside may be
+ * left unread. Empty means the whole frame.
+ */
+typedef std::vector<ByteRange> FrameRegion;
+
+/**
+ * Builds the region holding the rows of every plane of a (cropped) frame layout. Rows closer than
+ * maxGap bytes apart are merged, trading a little extra I/O for fewer requests.
+ * @param[in] g the frame layout, typically from cropGeometry().
+ * @param[in] maxGap largest gap between rows that is read through.
+ * @return the region.
+ */
+inline FrameRegion frameRegion(const FrameGeometry& g, size_t maxGap) {
+    FrameRegion region;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        const PlaneGeometry& pg = g.planes[p];
+        for (uint y = 0; y < pg.height; y++) {
+            ByteRange row = { pg.offset + y * pg.stride, (size_t) pg.width * g.bytesPerSample };
+            region.push_back(row);
+        }
+    }
+    std::sort(region.begin(), region.end(),
+              [](const ByteRange& a, const ByteRange& b) { return a.offset < b.offset; });
+
+    FrameRegion merged;
+    for (const ByteRange& r : region) {
+        if (!merged.empty() && r.offset <= merged.back().offset + merged.back().length + maxGap) {
+            ByteRange& last = merged.back();
+            last.length = std::max(last.offset + last.length, r.offset + r.length) - last.offset;
+        } else {
+            merged.push_back(r);
+        }
+    }
+    return merged;
+}
+
+/**
+ * Supplies whole raw frames of one video to the scoring loop.
+ *
+ * Frames are borrowed: acquire() returns a pointer to the first byte of frame f that stays valid
+ * until release(f). Both calls may come from any worker thread; frames are acquired in roughly
+ * increasing order.
+ */
+class FrameSource {
+public:
+    /**
+     * frameCount() of a stream whose length is only known once it hits end of file.
+     */
+    static const size_t UNKNOWN_FRAMES = std::numeric_limits<size_t>::max();
+
+    virtual ~FrameSource() {}
+
+    /**
+     * @return the number of complete frames in the video, or UNKNOWN_FRAMES for a stream.
+     */
+    virtual size_t frameCount() const = 0;
+
+    /**
+     * @return the most frames that may be held (acquired but not released) at once without
+     *         deadlocking the source.
+     */
+    virtual size_t maxHeldFrames() const { return std::numeric_limits<size_t>::max(); }
+
+    /**
+     * Blocks until frame f is available.
+     * @param[in] f the frame index, less than frameCount().
+     * @return pointer to the first byte of the frame, or nullptr if a stream ended before frame f.
+     *         Frames for which nullptr was returned must not be released.
+     * @throws VideoInfoError if reading the input failed.
+     */
+    virtual const uint8_t* acquire(size_t f) = 0;
+
+    /**
+     * Returns a frame obtained from acquire() so its storage can be reused.
+     * @param[in] f the frame index.
+     */
+    virtual void release(size_t f) = 0;
+};
+
+/**
+ * Frames served straight out of a memory-mapped file; acquire() is pointer arithmetic.
+ */
+class MappedFrameSource : public FrameSource {
+public:
+    /**
+     * @param[in] path the raw video file.
+     * @param[in] bytesPerFrame size of one frame.
+     * @param[in] sampling the frames to serve.
+     * @param[in] region the part of each frame that is accessed; only its pages are faulted in.
+     */
+    MappedFrameSource(const std::string& path, size_t bytesPerFrame,
+                      const FrameSampling& sampling = FrameSampling(),
+                      const FrameRegion& region = FrameRegion())
+            : file_(path), bytesPerFrame_(bytesPerFrame), sampling_(sampling), region_(region) {
+        if (!region_.empty()) {
+            // Sequential read-ahead would pull in whole frames; fault in just the region instead.
+            file_.randomAccess();
+        }
+    }
+
+    size_t frameCount() const override { return sampling_.count(file_.size() / bytesPerFrame_); }
+
+    const uint8_t* acquire(size_t f) override {
+        // Hint the kernel to page in the frame after this one while it is being scored.
+        size_t next = sampling_.frame(f + 1) * bytesPerFrame_;
+        if (region_.empty()) {
+            file_.willNeed(next, bytesPerFrame_);
+        }
+        for (const ByteRange& r : region_) {
+            file_.willNeed(next + r.offset, r.length);
+        }
+        return file_.data() + sampling_.frame(f) * bytesPerFrame_;
+    }
+
+    void release(size_t) override {}
+
+private:
+    MappedFile file_;
+    size_t bytesPerFrame_;
+    FrameSampling sampling_;
+    FrameRegion region_;
+};
+
+#endif // VIDEOINFO_FRAME_SOURCE_H
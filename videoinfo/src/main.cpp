@@ -4,7 +4,7 @@
 
 #include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <memory>
 #include <iostream>
 #include <regex>
 #include <sstream>
@@ -15,572 +15,585 @@
 #include <cstdio>
 #include <cmath>
 
+#include "container_reader.h"
+#include "frame_geometry.h"
+#include "frame_report.h"
+#include "frame_source.h"
+#include "prefetch_reader.h"
+#include "psnr.h"
+#include "run_stats.h"
+#include "score_cache.h"
+#include "sequence_score.h"
+#include "ssd.h"
+#include "ssim.h"
+#include "stream_reader.h"
+#include "tiles.h"
+#include "videoinfo.h"
+#include "worker_pool.h"
+
 using namespace std;
 
 #define VERSION "0.1.0"
 
-#define MAX_I(bits) ((1 << (bits)) - 1)
-#define MAX_I_8_BITS MAX_I(8)
-
 namespace {
 const size_t ERROR_IN_COMMAND_LINE = 1;
 const size_t SUCCESS = 0;
 const size_t ERROR_UNHANDLED_EXCEPTION = 2;
+// Rows of a --roi region closer than this are read as one span; below a page, splitting the read
+// saves no I/O.
+const size_t ROI_MAX_GAP = 4096;
 }
 namespace po = boost::program_options;
 
 typedef struct Context {
     std::string ref;             // reference video
-    std::string test;            // test video
+    std::vector<std::string> tests; // test videos, each scored against ref
     uint height, width;          // video height x width
-    // Sub-sampling parameters:
-    uint8_t J, a, b;             // J = horizontal sampling reference
-                                 // a = # of chrominance samples (Cr,Cb) in first row of J pixels
-                                 // b = # of changes of chrominance samples (Cr,Cb) between first &
-                                 //     second row of J pixels.
+    uint bitDepth;               // bits per sample; above 8, samples are 16-bit little-endian
+    PixelFormat pixelFormat;     // memory layout of the planes
+    uint threads;                // worker threads; 0 = one per core
+    std::string io;              // input method: "mmap" or "direct"
+    uint buffers;                // read-ahead ring size in frames ("direct" only)
+    uint queueDepth;             // reads kept in flight ("direct" only)
+    size_t start;                // first reference frame to score
+    size_t count;                // frames to score per test; 0 = all
+    size_t every;                // score every K-th frame
+    long testOffset;             // test frame index minus matching reference frame index
+    unsigned metrics;            // Metric mask: which quality metrics to compute
+    unsigned aggregations;       // Aggregation mask: which sequence PSNR scores to print
+    uint roiX, roiY;             // --roi origin in luma samples
+    uint roiWidth, roiHeight;    // --roi size in luma samples; 0 = whole frame
+    uint tileWidth, tileHeight;  // --tile size in luma samples; 0 = no tiles
+    std::string tileOut;         // per-tile report file
+    std::string cache;           // sidecar file of per-frame results, empty if disabled
+    bool stats;                  // print a per-stage timing breakdown
+    bool perfCounters;           // add perf_event hardware counters to the breakdown
+    std::string perFrameOut;     // per-frame report file, empty if disabled
+    FrameReport::Format reportFormat;
 } Context;
 
-typedef struct {
-    uint8_t y;
-    uint8_t u;
-    uint8_t v;
-} YCbCr;
-
-#ifdef RGB888
 /**
- * YCbCr to RGB888
+ * Opens a video for reading with the input method selected on the command line. Pipes, FIFOs and
+ * "-" (stdin) cannot be mapped or read at an offset, so they are always read as streams. Frame
+ * containers written by videoinfo_pack are recognised by their header and decompressed as frames
+ * are acquired, whatever the input method.
+ * @param[in] c the parsed command line.
+ * @param[in] path the raw video file.
+ * @param[in] bytesPerFrame size of one frame.
+ * @param[in] sampling the frames to serve.
+ * @param[in] region the part of each frame that is scored; streams still read whole frames.
+ * @return the frame source.
  */
-inline void yuv2rgb(uint8_t Y, uint8_t Cb, uint8_t Cr, uint8_t *r, uint8_t *g, uint8_t *b) {
-
-    Cr = Cr - 128;
-    Cb = Cb - 128;
-
-    *r = Y + Cr + (Cr >> 2) + (Cr >> 3) + (Cr >> 5);
-    *g = Y - ((Cb >> 2) + (Cb >> 4) + (Cb >> 5)) - ((Cr >> 1) + (Cr >> 3) + (Cr >> 4) + (Cr >> 5));
-    *b = Y + Cb + (Cb >> 1) + (Cb >> 2) + (Cb >> 6);
-}
-#endif
-
-inline double psnr(double mse){
-    // ------------------------------------------------------------------------------------
-    //    MAX_I = 2^B-1 where B = max possible pixel value; for 8-bit sampling MAX_I = 255
-    //
-    //    PSNR = 20*log10(MAX_I) - 10*log10(mse) where MAX_I = 255
-    // ------------------------------------------------------------------------------------
-    double psnr = 48.130803609 - 10*log10(mse);
-    return (isinf(psnr)) ? 0 : psnr; // Return 0 if PSNR is infinite (i.e. 0dB)
+unique_ptr<FrameSource> openFrameSource(const Context& c, const string& path, size_t bytesPerFrame,
+                                        const FrameSampling& sampling, const FrameRegion& region) {
+    if (StreamFrameSource::isStream(path)) {
+        return unique_ptr<FrameSource>(
+                new StreamFrameSource(path, bytesPerFrame, c.buffers, sampling));
+    }
+    if (ContainerFrameSource::isContainer(path)) {
+        return unique_ptr<FrameSource>(
+                new ContainerFrameSource(path, bytesPerFrame, c.buffers, sampling));
+    }
+    if (c.io == "direct") {
+        return unique_ptr<FrameSource>(new PrefetchFrameSource(path, bytesPerFrame, c.buffers,
+                                                               c.queueDepth, sampling, region));
+    }
+    return unique_ptr<FrameSource>(new MappedFrameSource(path, bytesPerFrame, sampling, region));
 }
 
-void readYUV444(const Context& c) {
-    auto frameSize = c.width * c.height;
-    auto bytesPerFrame = 3 * frameSize; // Y*frameSize + U*frameSize + V*frameSize
-
-    ifstream ref = ifstream(c.ref, ios::ate | ios::binary);
-    if(!ref) {
-        cerr << "ERROR: failed to open file: " << c.ref;
-        exit(1);
+/**
+ * @param[in] c the parsed command line.
+ * @param[in] ref the reference source.
+ * @param[in] tst the test sources.
+ * @return per test, the number of frames it shares with the reference, capped by --count.
+ */
+vector<size_t> testFrameCounts(const Context& c, const FrameSource& ref,
+                               const vector<unique_ptr<FrameSource> >& tst) {
+    vector<size_t> frames;
+    for (const auto& t : tst) {
+        frames.push_back(std::min(ref.frameCount(), t->frameCount()));
+        if (c.count) {
+            frames.back() = std::min(frames.back(), c.count);
+        }
     }
+    return frames;
+}
 
-    ifstream tst = ifstream(c.test, ios::ate | ios::binary);
-    if(!tst) {
-        cerr << "ERROR: failed to open file: " << c.test;
-        exit(1);
+/**
+ * @param[in] pool the worker pool.
+ * @param[in] ref the reference source.
+ * @param[in] tst the test sources.
+ * @return the number of frames to hand to the pool at once: a few per worker, within every
+ *         read-ahead ring so I/O can run a full batch ahead.
+ */
+size_t batchSize(const WorkerPool& pool, const FrameSource& ref,
+                 const vector<unique_ptr<FrameSource> >& tst) {
+    size_t maxHeld = ref.maxHeldFrames();
+    for (const auto& t : tst) {
+        maxHeld = std::min(maxHeld, t->maxHeldFrames());
     }
+    return std::max((size_t) 1, std::min((size_t) 4 * pool.size(), maxHeld / 2));
+}
 
-    auto rSizeBytes = ref.tellg();
-    auto tSizeBytes = tst.tellg();
-
-    ref.seekg(0, ios::beg);
-    tst.seekg(0, ios::beg);
-
-    auto rFrames = rSizeBytes / bytesPerFrame;
-    auto tFrames = tSizeBytes / bytesPerFrame;
-
-#ifdef DEBUG
-    cout << "bytesPerFrame = " << bytesPerFrame << endl;
-    cout << "rSize = " << rSizeBytes << ", tSize = " << tSizeBytes << endl;
-    cout << "rFrames = " << rFrames << ", tFrames = " << tFrames << endl;
-#endif
-
-    auto totalFrames = std::min(rFrames, tFrames);
-
-    uint32_t sum_fs = 0;
-    double seqScore = 0;
-
-    auto start = chrono::system_clock::now();
+/**
+ * @param[in] sum the sum of the per-frame values.
+ * @param[in] frames the number of frames summed.
+ * @return the mean per-frame value, or 0 when no frames were summed, as Scorer::sequence() reports.
+ */
+double frameMean(const KahanSum& sum, size_t frames) {
+    return frames == 0 ? 0 : sum.value() / frames;
+}
 
-    for (int f = 0; f < totalFrames; f++) {
-        uint32_t frameOffset = f * bytesPerFrame; // f * w * h = byte offset for current frame
-        double frameScore = 0;
+/**
+ * @param[in] c the parsed command line.
+ * @param[in] g the frame layout that is scored.
+ * @return everything cached results depend on, for the --cache header.
+ */
+string cacheLayout(const Context& c, const FrameGeometry& g) {
+    ostringstream layout;
+    layout << c.width << "x" << c.height << " shift " << g.chromaShiftX << "," << g.chromaShiftY
+           << " depth " << c.bitDepth << " roi " << c.roiX << "," << c.roiY << "," << c.roiWidth
+           << "," << c.roiHeight << " offset " << c.testOffset << " format " << c.pixelFormat;
 #ifdef RGB888
-        uint32_t mse_r = 0, mse_b = 0, mse_g = 0;
-        double psnr_r = 0, psnr_b = 0, psnr_g = 0;
-#else
-        uint32_t mse_y = 0, mse_u = 0, mse_v = 0;
-        double psnr_y = 0, psnr_u = 0, psnr_v = 0;
+    layout << " rgb888";
 #endif
+    return layout.str();
+}
 
-        for (int y = 0; y < c.height; ++y) {
-            char rYBuf[c.width], rUBuf[c.width], rVBuf[c.width];
-            char tYBuf[c.width], tUBuf[c.width], tVBuf[c.width];
-
-            uint32_t offsetY = 0 * frameSize + y * c.width;
-            uint32_t offsetU = 1 * frameSize + y * c.width;
-            uint32_t offsetV = 2 * frameSize + y * c.width;
-
-            //--------------------------------------------------------------------------------------
-            // OPTIMIZATION:
-            //
-            // To improve cache locality, load rows of bytes from each of Y, U, V components. The
-            // key is to access memory elements that are contiguous, so the fetch cost is only paid
-            // when fetching the 1st of N contiguous elements.
-            //--------------------------------------------------------------------------------------
-
-            // Reference File
-            ref.seekg(frameOffset + offsetY); // 1 row of Y
-            ref.read(rYBuf, sizeof(rYBuf));
-            ref.seekg(frameOffset + offsetU); // 1 row of U
-            ref.read(rUBuf, sizeof(rUBuf));
-            ref.seekg(frameOffset + offsetV); // 1 row of V
-            ref.read(rVBuf, sizeof(rVBuf));
-
-            // Test File
-            tst.seekg(frameOffset + offsetY); // 1 row of Y
-            tst.read(tYBuf, sizeof(tYBuf));
-            tst.seekg(frameOffset + offsetU); // 1 row of U
-            tst.read(tUBuf, sizeof(tUBuf));
-            tst.seekg(frameOffset + offsetV); // 1 row of V
-            tst.read(tVBuf, sizeof(tVBuf));
-
-            for (int x = 0; x < c.width; ++x) {
-                // 4:4:4
-                YCbCr r, t;
-
-                r.y = *(rYBuf + x);
-                r.u = *(rUBuf + x);
-                r.v = *(rVBuf + x);
-
-                t.y = *(tYBuf + x);
-                t.u = *(tUBuf + x);
-                t.v = *(tVBuf + x);
-#ifdef RGB888
-                uint8_t rr, rg, rb;
-                uint8_t tr, tg, tb;
-
-                yuv2rgb(r.y, r.u, r.v, &rr, &rg, &rb);
-                yuv2rgb(t.y, t.u, t.v, &tr, &tg, &tb);
+/**
+ * Finds how many leading frames of the selection can be served from the --cache: the cache holds
+ * results with every requested metric for them and the fingerprints of both frames still match.
+ * Cached frames are read and hashed but not scored, and inputs the cache knows are unchanged are
+ * not read at all; for a capture that grew only the new frames are scored afterwards.
+ * @param[in] c the parsed command line.
+ * @param[in] cache the loaded cache.
+ * @param[in] pool the worker pool.
+ * @param[in] bytesPerFrame size of one frame.
+ * @param[in] refSampling the reference frames selected.
+ * @param[in] testSampling the test frames selected.
+ * @param[in] fingerprintRegion the bytes covered by a fingerprint.
+ * @param[out] testFrames per test, the number of frames selected (see testFrameCounts()).
+ * @return the number of leading frames served from the cache; 0 when an input is a stream, since
+ *         a stream cannot be read twice.
+ */
+size_t cachedPrefix(const Context& c, const ScoreCache& cache, WorkerPool& pool,
+                    size_t bytesPerFrame, const FrameSampling& refSampling,
+                    const FrameSampling& testSampling, const FrameRegion& fingerprintRegion,
+                    vector<size_t>* testFrames) {
+    bool streams = StreamFrameSource::isStream(c.ref);
+    for (const string& test : c.tests) {
+        streams = streams || StreamFrameSource::isStream(test);
+    }
+    if (streams) {
+        return 0;
+    }
 
-                mse_r += (rr - tr) * (rr - tr);
-                mse_b += (rg - tg) * (rg - tg);
-                mse_g += (rb - tb) * (rb - tb);
+    unique_ptr<FrameSource> ref =
+            openFrameSource(c, c.ref, bytesPerFrame, refSampling, fingerprintRegion);
+    vector<unique_ptr<FrameSource> > tst;
+    for (const string& test : c.tests) {
+        tst.push_back(openFrameSource(c, test, bytesPerFrame, testSampling, fingerprintRegion));
+    }
+    *testFrames = testFrameCounts(c, *ref, tst);
+    size_t totalFrames = *std::max_element(testFrames->begin(), testFrames->end());
+    size_t batchFrames = batchSize(pool, *ref, tst);
+    bool hashRef = false;
+    for (size_t k = 0; k < tst.size(); k++) {
+        hashRef = hashRef || !cache.unchanged(k);
+    }
 
-#else
-                mse_y += (r.y - t.y) * (r.y - t.y);
-                mse_u += (r.u - t.u) * (r.u - t.u);
-                mse_v += (r.v - t.v) * (r.y - t.v);
-#endif
+    vector<char> hit(batchFrames);
+    for (size_t first = 0; first < totalFrames; first += batchFrames) {
+        size_t count = std::min(batchFrames, totalFrames - first);
+        pool.parallelFor(count, [&](size_t i) {
+            size_t f = first + i;
+            const uint8_t* r = hashRef ? ref->acquire(f) : nullptr;
+            uint64_t refHash = r ? ScoreCache::fingerprint(r, fingerprintRegion) : 0;
+            bool cached = true;
+            for (size_t k = 0; k < tst.size(); k++) {
+                if (f >= (*testFrames)[k]) {
+                    continue;
+                }
+                const CacheEntry* e = cache.find(k, refSampling.frame(f));
+                bool match = e && (e->metrics & c.metrics) == c.metrics;
+                if (!cache.unchanged(k)) {
+                    const uint8_t* t = tst[k]->acquire(f);
+                    match = match && e->refHash == refHash &&
+                            e->testHash == ScoreCache::fingerprint(t, fingerprintRegion);
+                    tst[k]->release(f);
+                }
+                cached = cached && match;
+            }
+            if (r) {
+                ref->release(f);
+            }
+            hit[i] = cached;
+        });
+        for (size_t i = 0; i < count; i++) {
+            if (!hit[i]) {
+                return first + i;
             }
         }
-#ifdef RGB888
-        psnr_r = psnr(mse_r / frameSize);
-        psnr_g = psnr(mse_g / frameSize);
-        psnr_b = psnr(mse_b / frameSize);
-
-        frameScore = (psnr_r + psnr_g + psnr_b) / 3;
-#else
-        psnr_y = psnr(mse_y / frameSize);
-        psnr_u = psnr(mse_u / frameSize);
-        psnr_v = psnr(mse_v / frameSize);
-
-        frameScore = (psnr_y + psnr_u + psnr_v) / 3;
-#endif
-
-#ifdef DEBUG
-        cout << "Frame #" << f << ":" << endl;
-        cout << "   Score: " << frameScore << "dB" << endl;
-        cout << "   Byte Range: [" << frameOffset << "," << (frameOffset + bytesPerFrame - 1) << "]"
-                << endl;
-#endif
-        sum_fs += frameScore;
     }
-
-    auto end = chrono::system_clock::now();
-    chrono::duration<double> diff = end - start;
-
-    cout << "Sequence Score: " << psnr(sum_fs / totalFrames) << "dB" << endl;
-    cout << "FPS: " << (totalFrames/diff.count()) << "/sec" << endl;
-
-    ref.close();
-    tst.close();
+    return totalFrames;
 }
 
-void readYUV422(const Context& c) {
-    auto frameSize = c.width * c.height;
-    auto bytesPerFrame = 2 * frameSize; // Y*frameSize + 0.5*U*frameSize + 0.5*V*frameSize
-
-    ifstream ref = ifstream(c.ref, ios::ate | ios::binary);
-    if(!ref) {
-        cerr << "ERROR: failed to open file: " << c.ref;
-        exit(1);
+/**
+ * Computes frame and sequence PSNR between the reference video and each test video in the context.
+ * One instantiation exists per subsampling scheme S; the frame layout comes from S::geometry().
+ * @param[in] c the parsed command line.
+ */
+template <class S>
+void readYUV(const Context& c) {
+    FrameGeometry g = S::geometry(c.width, c.height, c.bitDepth);
+    if (c.pixelFormat != PIX_FMT_PLANAR) {
+        g = interleaveGeometry(g, c.pixelFormat);
     }
-
-    ifstream tst = ifstream(c.test, ios::ate | ios::binary);
-    if(!tst) {
-        cerr << "ERROR: failed to open file: " << c.test;
-        exit(1);
+    size_t bytesPerFrame = g.bytesPerFrame;
+    size_t numTests = c.tests.size();
+
+    // With --roi every kernel works on a cropped view of the frame, and the sources only read the
+    // rows of each plane that the view covers.
+    FrameRegion region;
+    size_t bytesScored = bytesPerFrame;
+    if (c.roiWidth) {
+        g = cropGeometry(g, c.roiX, c.roiY, c.roiWidth, c.roiHeight);
+        region = frameRegion(g, ROI_MAX_GAP);
+        bytesScored = 0;
+        for (const ByteRange& r : region) {
+            bytesScored += r.length;
+        }
     }
 
-    auto rSizeBytes = ref.tellg();
-    auto tSizeBytes = tst.tellg();
+    TileGrid grid = { 0, 0, 0, 0 };
+    if (c.tileWidth) {
+        grid = TileGrid::make(g, c.tileWidth, c.tileHeight);
+    }
+    size_t tileValues = grid.count() * NUM_PLANES;
+
+    // Frame selection is pushed down into the sources, which turn it into offsets: frames that are
+    // not scored are never read (streams have to drain them). A negative test offset means the
+    // test dropped leading frames, so the reference starts late enough to have a match.
+    FrameSampling refSampling, testSampling;
+    refSampling.first = std::max(c.start, (size_t) std::max(-c.testOffset, 0L));
+    refSampling.step = testSampling.step = c.every;
+    testSampling.first = refSampling.first + c.testOffset;
+
+    // Counters inherited by the workers are only folded in once they exit, so they are opened
+    // before the pool is created and read after it is destroyed.
+    PerfCounters perf;
+    if (c.stats && c.perfCounters) {
+        perf.start();
+    }
+    unique_ptr<WorkerPool> pool(new WorkerPool(c.threads));
+    unique_ptr<RunStats> stats;
+    if (c.stats) {
+        stats.reset(new RunStats(pool->size()));
+    }
 
-    ref.seekg(0, ios::beg);
-    tst.seekg(0, ios::beg);
+    auto start = RunStats::Clock::now();
+
+    // With --cache, the leading frames whose results are still valid are only hashed; the sources
+    // start at the first frame that has to be scored. Later frames are still looked up in the
+    // cache as they are read, so only new or changed frames reach the kernels.
+    unique_ptr<ScoreCache> cache;
+    FrameRegion fingerprintRegion;
+    size_t resume = 0;
+    vector<size_t> testFrames;
+    if (!c.cache.empty()) {
+        cache.reset(new ScoreCache(c.cache, cacheLayout(c, g), c.ref, c.tests));
+        fingerprintRegion = ScoreCache::fingerprintRegion(region, bytesPerFrame);
+        resume = cachedPrefix(c, *cache, *pool, bytesPerFrame, refSampling, testSampling,
+                              fingerprintRegion, &testFrames);
+    }
+    FrameSampling refRead = refSampling, testRead = testSampling;
+    refRead.first = refSampling.frame(resume);
+    testRead.first = testSampling.frame(resume);
+
+    unique_ptr<FrameSource> ref = openFrameSource(c, c.ref, bytesPerFrame, refRead, region);
+    vector<unique_ptr<FrameSource> > tst;
+    for (const string& test : c.tests) {
+        tst.push_back(openFrameSource(c, test, bytesPerFrame, testRead, region));
+    }
 
-    auto rFrames = rSizeBytes / bytesPerFrame;
-    auto tFrames = tSizeBytes / bytesPerFrame;
+    // Each test is scored over the frames it shares with the reference; the reference is read up
+    // to the longest of them. Streams start out as UNKNOWN_FRAMES and are trimmed when they end.
+    if (!resume) {
+        testFrames = testFrameCounts(c, *ref, tst);
+    }
+    size_t totalFrames = *std::max_element(testFrames.begin(), testFrames.end());
 
 #ifdef DEBUG
     cout << "bytesPerFrame = " << bytesPerFrame << endl;
-    cout << "rSize = " << rSizeBytes << ", tSize = " << tSizeBytes << endl;
-    cout << "rFrames = " << rFrames << ", tFrames = " << tFrames << endl;
-#endif
-
-    auto totalFrames = std::min(rFrames, tFrames);
-
-    uint32_t sum_fs = 0;
-    double seqScore = 0;
-
-    auto start = chrono::system_clock::now();
-
-    for (int f = 0; f < totalFrames; f++) {
-        uint32_t frameOffset = f * bytesPerFrame; // f * bytesPerFrame = byte offset for current frame
-        double frameScore = 0;
-#ifdef RGB888
-        uint32_t mse_r = 0, mse_b = 0, mse_g = 0;
-        double psnr_r = 0, psnr_b = 0, psnr_g = 0;
-#else
-        uint32_t mse_y = 0, mse_u = 0, mse_v = 0;
-        double psnr_y = 0, psnr_u = 0, psnr_v = 0;
+    cout << "rFrames = " << ref->frameCount();
+    for (size_t t = 0; t < numTests; t++) {
+        cout << ", tFrames[" << t << "] = " << tst[t]->frameCount();
+    }
+    cout << endl;
 #endif
 
-        for (int y = 0; y < c.height; ++y) {
-            char rYBuf[c.width], rUBuf[c.width], rVBuf[c.width];
-            char tYBuf[c.width], tUBuf[c.width], tVBuf[c.width];
+    vector<SequenceScore> sequences(numTests, SequenceScore(g));
+    vector<KahanSum> sum_ssim(numTests), sum_msssim(numTests);
+    const unsigned similarity = c.metrics & (METRIC_SSIM | METRIC_MSSSIM);
 
-            uint32_t offsetY = 0 * frameSize + y * c.width;
-            uint32_t offsetU = 1 * frameSize + (y / 2) * c.width;
-            uint32_t offsetV = 1.5 * frameSize + (y / 2) * c.width;
+    unique_ptr<FrameReport> report;
+    if (!c.perFrameOut.empty()) {
+        report.reset(new FrameReport(c.perFrameOut, c.reportFormat, g, c.tests, c.metrics));
+    }
+    unique_ptr<TileReport> tileReport;
+    if (grid.count()) {
+        tileReport.reset(new TileReport(c.tileOut, c.reportFormat, g, grid, c.roiX, c.roiY,
+                                        c.tests));
+    }
 
-#ifdef FINE
-            cout << "OffsetY = " << (frameOffset + offsetY) << endl;
-            cout << "OffsetU = " << (frameOffset + offsetU) << endl;
-            cout << "OffsetV = " << (frameOffset + offsetV) << endl;
-#endif
-            //--------------------------------------------------------------------------------------
-            // OPTIMIZATION:
-            //
-            // To improve cache locality, load rows of bytes from each of Y, U, V components. The
-            // key is to access memory elements that are contiguous, so the fetch cost is only paid
-            // when fetching the 1st of N contiguous elements.
-            //--------------------------------------------------------------------------------------
-
-            // Reference File
-            ref.seekg(frameOffset + offsetY); // 1 row of Y
-            ref.read(rYBuf, sizeof(rYBuf));
-            if( y % 2 == 0) {
-                // Each row of U & V bytes contains enough information for 2 rows of Y bytes; hence
-                // load new data for U and V on every even numbered Y row.
-                ref.seekg(frameOffset + offsetU); // 1 row of U
-                ref.read(rUBuf, sizeof(rUBuf));
-                ref.seekg(frameOffset + offsetV); // 1 row of V
-                ref.read(rVBuf, sizeof(rVBuf));
+    //----------------------------------------------------------------------------------------------
+    // OPTIMIZATION:
+    //
+    // Frames are independent, so each batch is scored in parallel across the pool. Results land in
+    // a per-batch array indexed by frame and are reduced in frame order on this thread, which keeps
+    // the sequence score bit-identical to a single-threaded run. Every reference frame is acquired
+    // once and scored against all test videos, with every selected metric, while it is still in
+    // cache.
+    //----------------------------------------------------------------------------------------------
+    size_t batchFrames = batchSize(*pool, *ref, tst);
+    vector<FrameSSE> batch(batchFrames * numTests);
+    vector<FrameSSIM> batchSSIM(similarity ? batchFrames * numTests : 0);
+    vector<char> scored(batchFrames * numTests);
+    vector<uint64_t> batchTiles(batchFrames * numTests * tileValues);
+    // With --cache: fingerprints of each reference and test frame read, and whether its results
+    // came from the cache.
+    vector<uint64_t> batchHashes(cache ? 2 * batchFrames * numTests : 0);
+    vector<char> cached(cache ? batchFrames * numTests : 0);
+
+    for (size_t first = 0; first < totalFrames; first += batchFrames) {
+        size_t count = std::min(batchFrames, (size_t) (totalFrames - first));
+
+        pool->parallelFor(count, [&](size_t i) {
+            size_t f = first + i;
+            if (f < resume) {
+                // Served from the cache during the reduction.
+                for (size_t k = 0; k < numTests; k++) {
+                    scored[i * numTests + k] = (f < testFrames[k]);
+                }
+                return;
             }
-
-            // Test File
-            tst.seekg(frameOffset + offsetY); // 1 row of Y
-            tst.read(tYBuf, sizeof(tYBuf));
-            if( y % 2 == 0) {
-                tst.seekg(frameOffset + offsetU); // 1 row of U
-                tst.read(tUBuf, sizeof(tUBuf));
-                tst.seekg(frameOffset + offsetV); // 1 row of V
-                tst.read(tVBuf, sizeof(tVBuf));
+            vector<const uint8_t*> t(numTests, nullptr);
+            RunStats::Clock::time_point t0, t1, t2;
+            if (stats) {
+                t0 = RunStats::Clock::now();
             }
-
-            for (int x = 0; x < c.width; ++x) {
-                // 4:2:2
-                YCbCr r, t;
-
-                r.y = *(rYBuf + x);
-                t.y = *(tYBuf + x);
-                if( x % 2 == 0) {
-                    // For every even column number, read from U and V buffer.
-                    r.u = *(rUBuf + x);
-                    r.v = *(rVBuf + x);
-                    t.u = *(tUBuf + x);
-                    t.v = *(tVBuf + x);
-
-                } else {
-                    // For every odd column, read the value of U and V buffer values from the even
-                    // column before.
-                    r.u = *(rUBuf + x - 1);
-                    r.v = *(rVBuf + x - 1);
-                    t.u = *(tUBuf + x - 1);
-                    t.v = *(tVBuf + x - 1);
+            const uint8_t* r = ref->acquire(f - resume);
+            if (r) {
+                for (size_t k = 0; k < numTests; k++) {
+                    if (f < testFrames[k]) {
+                        t[k] = tst[k]->acquire(f - resume);
+                    }
                 }
-#ifdef RGB888
-                uint8_t rr, rg, rb;
-                uint8_t tr, tg, tb;
-
-                yuv2rgb(r.y, r.u, r.v, &rr, &rg, &rb);
-                yuv2rgb(t.y, t.u, t.v, &tr, &tg, &tb);
+                if (stats) {
+                    t1 = RunStats::Clock::now();
+                    stats->addRead(WorkerPool::threadIndex(), t1 - t0);
+                }
+                // Tests whose cached results still match are not scored again.
+                vector<const uint8_t*> todo = t;
+                uint64_t refHash = 0;
+                bool refHashed = false;
+                for (size_t k = 0; cache && k < numTests; k++) {
+                    size_t slot = i * numTests + k;
+                    cached[slot] = false;
+                    if (!t[k]) {
+                        continue;
+                    }
+                    const CacheEntry* e = cache->find(k, refSampling.frame(f));
+                    bool match = e && (e->metrics & c.metrics) == c.metrics;
+                    if (!match || !cache->unchanged(k)) {
+                        if (!refHashed) {
+                            refHash = ScoreCache::fingerprint(r, fingerprintRegion);
+                            refHashed = true;
+                        }
+                        uint64_t testHash = ScoreCache::fingerprint(t[k], fingerprintRegion);
+                        batchHashes[2 * slot] = refHash;
+                        batchHashes[2 * slot + 1] = testHash;
+                        match = match && e->refHash == refHash && e->testHash == testHash;
+                    }
+                    if (match) {
+                        batch[slot] = e->e;
+                        if (similarity) {
+                            batchSSIM[slot] = e->q;
+                        }
+                        cached[slot] = true;
+                        todo[k] = nullptr;
+                    }
+                }
+                if (stats) {
+                    t2 = RunStats::Clock::now();
+                    if (cache) {
+                        stats->addFingerprint(WorkerPool::threadIndex(), t2 - t1);
+                    }
+                }
+                bool kernels = false;
+                for (size_t k = 0; k < numTests; k++) {
+                    kernels = kernels || todo[k];
+                }
+                if (tileValues) {
+                    // The frame SSE is the sum of its tiles, so tiling replaces the frame pass.
+                    uint64_t* tiles = &batchTiles[i * numTests * tileValues];
+                    tileSSE(g, grid, r, todo.data(), numTests, tiles);
+                    for (size_t k = 0; k < numTests; k++) {
+                        if (!todo[k]) {
+                            continue;
+                        }
+                        FrameSSE& e = batch[i * numTests + k];
+                        e = FrameSSE{{0, 0, 0}};
+                        for (size_t v = 0; v < tileValues; v++) {
+                            e.sse[v % NUM_PLANES] += tiles[k * tileValues + v];
+                        }
+                    }
+                } else if (c.metrics & METRIC_PSNR) {
+                    frameSSE<S>(g, r, todo.data(), numTests, &batch[i * numTests]);
+                }
+                for (size_t k = 0; similarity && k < numTests; k++) {
+                    if (todo[k]) {
+                        batchSSIM[i * numTests + k] = frameSSIM(g, r, todo[k], similarity);
+                    }
+                }
+                if (stats && kernels) {
+                    stats->addFrame(WorkerPool::threadIndex(), RunStats::Clock::now() - t2);
+                }
+                ref->release(f - resume);
+            }
+            for (size_t k = 0; k < numTests; k++) {
+                scored[i * numTests + k] = (t[k] != nullptr);
+                if (t[k]) {
+                    tst[k]->release(f - resume);
+                }
+            }
+        });
 
-                mse_r += (rr - tr) * (rr - tr);
-                mse_b += (rg - tg) * (rg - tg);
-                mse_g += (rb - tb) * (rb - tb);
+        RunStats::Clock::time_point aggregationStart;
+        if (stats) {
+            aggregationStart = RunStats::Clock::now();
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t f = first + i;
+            for (size_t k = 0; k < numTests; k++) {
+                if (f >= testFrames[k]) {
+                    continue;
+                }
+                if (!scored[i * numTests + k]) {
+                    // The test or the reference stream ended at this frame.
+                    testFrames[k] = f;
+                    continue;
+                }
+                if (stats && f >= resume) {
+                    // The reference frame is counted with its first test.
+                    bool refCounted = false;
+                    for (size_t j = 0; j < k; j++) {
+                        refCounted = refCounted || scored[i * numTests + j];
+                    }
+                    stats->addBytes((refCounted ? 1 : 2) * bytesScored);
+                }
+                size_t slot = i * numTests + k;
+                if (f < resume) {
+                    const CacheEntry* entry = cache->find(k, refSampling.frame(f));
+                    batch[slot] = entry->e;
+                    if (similarity) {
+                        batchSSIM[slot] = entry->q;
+                    }
+                } else if (cache && !cached[slot]) {
+                    CacheEntry entry;
+                    entry.refHash = batchHashes[2 * slot];
+                    entry.testHash = batchHashes[2 * slot + 1];
+                    entry.metrics = c.metrics;
+                    entry.e = batch[slot];
+                    entry.q = similarity ? batchSSIM[slot] : FrameSSIM();
+                    cache->store(k, refSampling.frame(f), entry);
+                }
+                const FrameSSE& e = batch[slot];
+                double score = (c.metrics & METRIC_PSNR) ? frameScore(g, e) : 0;
+                FrameSSIM q = similarity ? batchSSIM[slot] : FrameSSIM();
 
-#else
-                mse_y += (r.y - t.y) * (r.y - t.y);
-                mse_u += (r.u - t.u) * (r.u - t.u);
-                mse_v += (r.v - t.v) * (r.y - t.v);
+#ifdef DEBUG
+                // byte offset for current frame
+                size_t frameOffset = refSampling.frame(f) * bytesPerFrame;
+                cout << "Frame #" << refSampling.frame(f) << ":" << endl;
+                if (numTests > 1) {
+                    cout << "   Test: " << c.tests[k] << endl;
+                }
+                cout << "   Score: " << score << "dB" << endl;
+                cout << "   Byte Range: [" << frameOffset << ","
+                        << (frameOffset + bytesPerFrame - 1) << "]" << endl;
 #endif
+                if (report) {
+                    report->write(k, refSampling.frame(f), e, score, q);
+                }
+                if (tileReport) {
+                    tileReport->write(k, refSampling.frame(f),
+                                      &batchTiles[(i * numTests + k) * tileValues]);
+                }
+                if (c.metrics & METRIC_PSNR) {
+                    sequences[k].add(e);
+                }
+                sum_ssim[k].add(planeAverage(q.ssim));
+                sum_msssim[k].add(planeAverage(q.msssim));
             }
         }
-#ifdef RGB888
-        psnr_r = psnr(mse_r / frameSize);
-        psnr_g = psnr(mse_g / frameSize);
-        psnr_b = psnr(mse_b / frameSize);
-
-        frameScore = (psnr_r + psnr_g + psnr_b) / 3;
-#else
-        psnr_y = psnr(mse_y / frameSize);
-        psnr_u = psnr(mse_u / frameSize);
-        psnr_v = psnr(mse_v / frameSize);
 
-        frameScore = (psnr_y + psnr_u + psnr_v) / 3;
-#endif
-
-#ifdef DEBUG
-        cout << "Frame #" << f << ":" << endl;
-        cout << "   Score: " << frameScore << "dB" << endl;
-        cout << "   Byte Range: [" << frameOffset << "," << (frameOffset + bytesPerFrame - 1) << "]"
-                << endl;
-#endif
-        sum_fs += frameScore;
+        totalFrames = *std::max_element(testFrames.begin(), testFrames.end());
+        if (stats) {
+            stats->addAggregation(RunStats::Clock::now() - aggregationStart);
+        }
     }
 
-    auto end = chrono::system_clock::now();
-    chrono::duration<double> diff = end - start;
-
-    cout << "Sequence Score: " << psnr(sum_fs / totalFrames) << "dB" << endl;
-    cout << "FPS: " << (totalFrames/diff.count()) << "/sec" << endl;
-
-    ref.close();
-    tst.close();
-}
-
-
-void readYUV420(const Context& c) {
-    auto frameSize = c.width * c.height;
-    auto bytesPerFrame = 1.5 * frameSize; // Y*frameSize + 0.5*U*frameSize + 0.0*V*frameSize
-
-    ifstream ref = ifstream(c.ref, ios::ate | ios::binary);
-    if(!ref) {
-        cerr << "ERROR: failed to open file: " << c.ref;
-        exit(1);
+    if (cache) {
+        cache->save();
     }
+    auto end = RunStats::Clock::now();
+    chrono::duration<double> diff = end - start;
+    pool.reset();
 
-    ifstream tst = ifstream(c.test, ios::ate | ios::binary);
-    if(!tst) {
-        cerr << "ERROR: failed to open file: " << c.test;
+    if (totalFrames == 0) {
+        cerr << "ERROR: no frames to score!" << endl;
         exit(1);
     }
 
-    auto rSizeBytes = ref.tellg();
-    auto tSizeBytes = tst.tellg();
-
-    ref.seekg(0, ios::beg);
-    tst.seekg(0, ios::beg);
-
-    auto rFrames = rSizeBytes / bytesPerFrame;
-    auto tFrames = tSizeBytes / bytesPerFrame;
-
-#ifdef DEBUG
-    cout << "bytesPerFrame = " << bytesPerFrame << endl;
-    cout << "rSize = " << rSizeBytes << ", tSize = " << tSizeBytes << endl;
-    cout << "rFrames = " << rFrames << ", tFrames = " << tFrames << endl;
-#endif
-
-    auto totalFrames = std::min(rFrames, tFrames);
-
-    uint32_t sum_fs = 0;
-    double seqScore = 0;
-
-    auto start = chrono::system_clock::now();
-
-    for (int f = 0; f < totalFrames; f++) {
-        uint32_t frameOffset = f * bytesPerFrame; // f * bytesPerFrame = byte offset for current frame
-        double frameScore = 0;
-#ifdef RGB888
-        uint32_t mse_r = 0, mse_b = 0, mse_g = 0;
-        double psnr_r = 0, psnr_b = 0, psnr_g = 0;
-#else
-        uint32_t mse_y = 0, mse_u = 0, mse_v = 0;
-        double psnr_y = 0, psnr_u = 0, psnr_v = 0;
-#endif
-
-        for (int y = 0; y < c.height; y+=2) {
-            char rY1Buf[c.width], rY2Buf[c.width], rUBuf[c.width], rVBuf[c.width];
-            char tY1Buf[c.width], tY2Buf[c.width], tUBuf[c.width], tVBuf[c.width];
-
-            uint32_t offsetY1 = 0 * frameSize + y * c.width;
-            uint32_t offsetY2 = 0 * frameSize + (y + 1) * c.width;
-            uint32_t offsetU = 1 * frameSize + (y / 2) * c.width;
-            uint32_t offsetV = 1.25 * frameSize + (y / 2) * c.width;
-
-
-#ifdef FINE
-            cout << "OffsetY1 = " << (frameOffset + offsetY) << endl;
-            cout << "OffsetY2 = " << (frameOffset + offsetV) << endl;
-            cout << "OffsetU = " << (frameOffset + offsetU) << endl;
-            cout << "OffsetV = " << (frameOffset + offsetV) << endl;
-
-#endif
-            //--------------------------------------------------------------------------------------
-            // OPTIMIZATION:
-            //
-            // For better cache locality when processing, load 2 rows of Y and 1 row of U. Process
-            // x and y elements in 2x2 squares since each square of 4 Y values shares 1 U and V
-            // value.
-            //--------------------------------------------------------------------------------------
-
-            // Reference File
-            ref.seekg(frameOffset + offsetY1); // 1st row of Y
-            ref.read(rY1Buf, sizeof(rY1Buf));
-            ref.seekg(frameOffset + offsetY2); // 2nd row of Y
-            ref.read(rY2Buf, sizeof(rY2Buf));
-            ref.seekg(frameOffset + offsetU); // 1 row of U
-            ref.read(rUBuf, sizeof(rUBuf));
-            ref.seekg(frameOffset + offsetV);  // 1 row of V
-            ref.read(rVBuf, sizeof(rVBuf));
-
-
-            // Test File
-            tst.seekg(frameOffset + offsetY1); // 1st row of Y
-            tst.read(tY1Buf, sizeof(tY1Buf));
-            tst.seekg(frameOffset + offsetY2); // 2nd row of V
-            tst.read(tY2Buf, sizeof(tY2Buf));
-            tst.seekg(frameOffset + offsetU); // 1 row of U
-            tst.read(tUBuf, sizeof(tUBuf));
-            tst.seekg(frameOffset + offsetV);  // 1 row of V
-            tst.read(tVBuf, sizeof(tVBuf));
-
-
-            for (int x = 0; x < c.width; x+=2) {
-                // 4:2:0
-
-                //
-                //     x=0   |   x=2   | ... | x = c.width
-                // ---------------------------
-                // | r1 | r2 | r1 | r2 | ... | Y1 Buffer
-                // ---U1/V1-----U2/V2---------
-                // | r3 | r4 | r3 | r4 | ... | Y2 Buffer
-                // ---------------------------
-                //
-                // where [r1.u to r4.u] = U_1, [r1.v to r4.v] = V_1
-                //
-                YCbCr r1, r2, r3, r4, t1, t2, t3, t4;
-
-
-                // Reference File
-                r1.y = *(rY1Buf + x);
-                r2.y = *(rY1Buf + x + 1);
-                r3.y = *(rY2Buf + x);
-                r4.y = *(rY2Buf + x + 1);
-                r1.u = *(rUBuf + x / 2);
-                r2.u = r1.u;
-                r3.u = r1.u;
-                r4.u = r1.u;
-                r1.v = *(rVBuf + x / 2);
-                r2.v = r1.v;
-                r3.v = r1.v;
-                r4.v = r1.v;
-
-                // Test File
-                t1.y = *(tY1Buf + x);
-                t2.y = *(tY1Buf + x + 1);
-                t3.y = *(tY2Buf + x);
-                t4.y = *(tY2Buf + x + 1);
-                t1.u = *(tUBuf + x / 2);
-                t2.u = t1.u;
-                t3.u = t1.u;
-                t4.u = t1.u;
-                t1.v = *(tVBuf + x / 2);
-                t2.v = t1.v;
-                t3.v = t1.v;
-                t4.v = t1.v;
-
-#ifdef RGB888
-		// TODO:[NOT IMPLEMENTED] 4:2:0 for RGB888 color space
-		uint8_t rr, rg, rb;
-                uint8_t tr, tg, tb;
-
-                yuv2rgb(r.y, r.u, r.v, &rr, &rg, &rb);
-                yuv2rgb(t.y, t.u, t.v, &tr, &tg, &tb);
-
-                mse_r += (rr - tr) * (rr - tr);
-                mse_b += (rg - tg) * (rg - tg);
-                mse_g += (rb - tb) * (rb - tb);
-
-#else
-                mse_y += (r1.y - t1.y) * (r1.y - t1.y);
-                mse_u += (r1.u - t1.u) * (r1.u - t1.u);
-                mse_v += (r1.v - t1.v) * (r1.y - t1.v);
-
-                mse_y += (r2.y - t2.y) * (r2.y - t2.y);
-                mse_u += (r2.u - t2.u) * (r2.u - t2.u);
-                mse_v += (r2.v - t2.v) * (r2.y - t2.v);
-
-                mse_y += (r3.y - t3.y) * (r3.y - t3.y);
-                mse_u += (r3.u - t3.u) * (r3.u - t3.u);
-                mse_v += (r3.v - t3.v) * (r3.y - t3.v);
-
-                mse_y += (r4.y - t4.y) * (r4.y - t4.y);
-                mse_u += (r4.u - t4.u) * (r4.u - t4.u);
-                mse_v += (r4.v - t4.v) * (r4.y - t4.v);
-#endif
+    bool unscored = false;
+    for (size_t k = 0; k < numTests; k++) {
+        if (testFrames[k] == 0) {
+            cerr << "ERROR: " << c.tests[k] << ": no frames to score!" << endl;
+            unscored = true;
+            continue;
+        }
+        string prefix = (numTests > 1) ? c.tests[k] + ": " : "";
+        SequenceSummary summary = sequences[k].summarize();
+        if (c.aggregations & AGGREGATE_MEAN) {
+            cout << prefix << "Sequence Score: " << summary.mean << "dB" << endl;
+        }
+        if (c.aggregations & AGGREGATE_WEIGHTED) {
+            cout << prefix << "Sequence Score (6:1:1): " << summary.weighted << "dB" << endl;
+        }
+        if (c.aggregations & AGGREGATE_GLOBAL) {
+            cout << prefix << "Global PSNR:";
+            for (int p = 0; p < NUM_PLANES; p++) {
+                cout << " " << planeName(p) << " " << summary.global[p] << "dB";
             }
+            cout << " all " << summary.globalAll << "dB" << endl;
+        }
+        if (c.metrics & METRIC_SSIM) {
+            cout << prefix << "Sequence SSIM: " << frameMean(sum_ssim[k], testFrames[k]) << endl;
+        }
+        if (c.metrics & METRIC_MSSSIM) {
+            cout << prefix << "Sequence MS-SSIM: " << frameMean(sum_msssim[k], testFrames[k])
+                    << endl;
         }
-#ifdef RGB888
-        psnr_r = psnr(mse_r / frameSize);
-        psnr_g = psnr(mse_g / frameSize);
-        psnr_b = psnr(mse_b / frameSize);
-
-        frameScore = (psnr_r + psnr_g + psnr_b) / 3;
-#else
-        psnr_y = psnr(mse_y / frameSize);
-        psnr_u = psnr(mse_u / frameSize);
-        psnr_v = psnr(mse_v / frameSize);
-
-        frameScore = (psnr_y + psnr_u + psnr_v) / 3;
-#endif
-
-#ifdef DEBUG
-        cout << "Frame #" << f << ":" << endl;
-        cout << "   Score: " << frameScore << "dB" << endl;
-        cout << "   Byte Range: [" << frameOffset << "," << (frameOffset + bytesPerFrame - 1) << "]"
-                << endl;
-#endif
-        sum_fs += frameScore;
     }
-
-    auto end = chrono::system_clock::now();
-    chrono::duration<double> diff = end - start;
-
-    cout << "Sequence Score: " << psnr(sum_fs / totalFrames) << "dB" << endl;
     cout << "FPS: " << (totalFrames/diff.count()) << "/sec" << endl;
 
-    ref.close();
-    tst.close();
+    if (stats) {
+        stats->print(cout, end - start, c.perfCounters ? &perf : nullptr);
+    }
+    if (unscored) {
+        exit(1);
+    }
 }
 
 inline void printUsage(const string appName, const po::options_description desc) {
@@ -592,12 +605,13 @@ inline void printUsage(const string appName, const po::options_description desc)
     ov.pop_back();
 
     cout << endl;
-    cout << "USAGE: " << appName << " -s SAMPLING -w WIDTH -h HEIGHT ref-file test-file" << endl;
-    cout << endl << "    Computes PSNR between a reference and test video streams." << endl;
+    cout << "USAGE: " << appName << " [-s SAMPLING | --pix-fmt FORMAT] -w WIDTH -h HEIGHT"
+            << " ref-file test-file [test-file ...]" << endl;
+    cout << endl << "    Computes PSNR between a reference and one or more test video streams." << endl;
     cout << desc << endl;
     cout << endl << "Positional Arguments: " << endl;
-    cout << "  ref-file              Reference video file" << endl;
-    cout << "  test-file             Test video file" << endl;
+    cout << "  ref-file              Reference video file, or '-' for stdin" << endl;
+    cout << "  test-file             Test video file(s); the reference is read once for all" << endl;
     cout << endl << "v" << VERSION << endl;
 }
 
@@ -606,6 +620,13 @@ int main(int argc, char** argv) {
     std::string appName = boost::filesystem::basename(argv[0]);
     Context context;
     string subSampling;
+    string pixelFormat;
+    string simd;
+    string reportFormat;
+    string metrics;
+    string aggregations;
+    string roi;
+    string tile;
     try {
         /** Define and parse the program options
          */
@@ -613,15 +634,36 @@ int main(int argc, char** argv) {
         po::options_description desc("Options");
         desc.add_options()
                 ("help", "Print help messages")
-                ("sampling,s",  po::value<string>(&subSampling)->required(), "One of '4:4:4', '4:2:2' , or '4:2:0'")
+                ("sampling,s",  po::value<string>(&subSampling), "One of '4:4:4', '4:2:2', '4:2:0', '4:1:1' or '4:4:0'; required for planar input")
                 ("height,h",    po::value<uint>(&context.height)->required(),"Height of video file")
                 ("width,w",     po::value<uint>(&context.width)->required(), "Width of video file")
+                ("bitdepth",    po::value<uint>(&context.bitDepth)->default_value(8), "Bits per sample, 8 to 16; above 8 samples are 16-bit little-endian (e.g. yuv420p10le)")
+                ("pix-fmt",     po::value<string>(&pixelFormat)->default_value("planar"), "Frame layout: 'planar', 'nv12', 'nv21', 'p010' (4:2:0 with interleaved chroma), 'yuyv' or 'uyvy' (packed 4:2:2); interleaved samples are scored in place")
+                ("threads,t",   po::value<uint>(&context.threads)->default_value(0), "Worker threads scoring frames in parallel (default: 0 = one per core)")
+                ("io",          po::value<string>(&context.io)->default_value("mmap"), "Input method: 'mmap' or 'direct' (O_DIRECT read-ahead threads; for inputs larger than the page cache). Pipes, FIFOs and '-' (stdin) are always streamed")
+                ("buffers",     po::value<uint>(&context.buffers)->default_value(16), "Frames in the read-ahead ring (--io direct and streams)")
+                ("queue-depth", po::value<uint>(&context.queueDepth)->default_value(4), "Reads kept in flight (--io direct)")
+                ("metrics",     po::value<string>(&metrics)->default_value("psnr"), "Comma-separated quality metrics: 'psnr', 'ssim', 'msssim'; all are computed in one pass")
+                ("aggregate",   po::value<string>(&aggregations)->default_value("mean"), "Comma-separated sequence PSNR scores: 'mean' (of frame scores), 'weighted' (mean of 6:1:1 Y:U:V frame scores), 'global' (per plane from the MSE over all frames, as x264 and ffmpeg report)")
+                ("start",       po::value<size_t>(&context.start)->default_value(0), "First reference frame to score")
+                ("count",       po::value<size_t>(&context.count)->default_value(0), "Number of frames to score (default: 0 = all)")
+                ("every",       po::value<size_t>(&context.every)->default_value(1), "Score every K-th frame; skipped frames are not read")
+                ("test-offset", po::value<long>(&context.testOffset)->default_value(0), "Test frame index minus the matching reference frame index; negative if the test dropped leading frames")
+                ("stats",       po::bool_switch(&context.stats), "Print time spent waiting on reads, checking the --cache, in kernels and in aggregation, bytes read and per-thread utilization")
+                ("perf-counters", po::bool_switch(&context.perfCounters), "With --stats, also report perf_event cycles, instructions and cache misses")
+                ("roi",         po::value<string>(&roi), "Score only the rectangle 'x,y,w,h' (luma samples); only its rows are read")
+                ("tile",        po::value<string>(&tile), "Split frames (or the --roi) into 'WxH' tiles and write per-tile MSE and PSNR to --tile-out")
+                ("tile-out",    po::value<string>(&context.tileOut), "Per-tile report file for --tile")
+                ("cache",       po::value<string>(&context.cache), "Sidecar file of per-frame results; on re-runs only frames that are new or changed since are scored")
+                ("per-frame-out", po::value<string>(&context.perFrameOut), "Write per-frame MSE, PSNR and score to this file")
+                ("format",      po::value<string>(&reportFormat)->default_value("csv"), "Per-frame and per-tile report format: 'csv' or 'json'")
+                ("simd",        po::value<string>(&simd), "Force SSD kernel: 'scalar', 'sse2', 'avx2' or 'avx512' (default: best supported)")
                 ("ref-file",    po::value<string>(&context.ref)->required(), "Reference video file")
-                ("test-file",   po::value<string>(&context.test)->required(),"Test video file");
+                ("test-file",   po::value<vector<string> >(&context.tests)->multitoken()->required(),"Test video file(s)");
 
         po::positional_options_description pos;
         pos.add("ref-file", 1);
-        pos.add("test-file",1);
+        pos.add("test-file",-1);
 
         po::variables_map vm;
         try {
@@ -649,37 +691,159 @@ int main(int argc, char** argv) {
 
     }
 
-    if (!regex_match(subSampling, regex("[0-9]:[0-9]:[0-9]"))) {
-        cerr << "ERROR: chroma subsampling parameter invalid format!" << endl;
+    if (!parsePixelFormat(pixelFormat, &context.pixelFormat)) {
+        cerr << "ERROR: unknown pixel format: " << pixelFormat << endl;
+        exit(-1);
+    }
+    if (!simd.empty()) {
+        int level = 0;
+        while (level < NUM_SIMD_LEVELS && simd != simdLevelName((SimdLevel) level)) {
+            level++;
+        }
+        if (level == NUM_SIMD_LEVELS) {
+            cerr << "ERROR: unknown SIMD level: " << simd << endl;
+            exit(-1);
+        }
+        if (setSimdLevel((SimdLevel) level) != level) {
+            cerr << "WARNING: " << simd << " not supported, using "
+                    << simdLevelName(currentSimdLevel()) << endl;
+        }
+    }
+
+    if (!FrameReport::parseFormat(reportFormat, &context.reportFormat)) {
+        cerr << "ERROR: unknown report format: " << reportFormat << endl;
+        exit(-1);
+    }
+
+    if (context.every == 0) {
+        cerr << "ERROR: --every must be at least 1!" << endl;
+        exit(-1);
+    }
+
+    if (!parseMetrics(metrics, &context.metrics)) {
+        cerr << "ERROR: unknown metrics: " << metrics << endl;
+        exit(-1);
+    }
+
+    // The library checks the video parameters and fills in what --pix-fmt implies.
+    ScorerOptions options;
+    options.width = context.width;
+    options.height = context.height;
+    options.sampling = subSampling;
+    options.bitDepth = context.bitDepth;
+    options.pixelFormat = context.pixelFormat;
+    options.metrics = context.metrics;
+    uint xShift, yShift;
+    try {
+        resolveOptions(&options, &xShift, &yShift);
+    } catch (const VideoInfoError& e) {
+        cerr << "ERROR: " << e.what() << "!" << endl;
+        exit(-1);
+    }
+    context.bitDepth = options.bitDepth;
+
+    if (!parseAggregations(aggregations, &context.aggregations)) {
+        cerr << "ERROR: unknown aggregation: " << aggregations << endl;
+        exit(-1);
+    }
+    if (!(context.metrics & METRIC_PSNR)) {
+        context.aggregations = 0;
+    }
+#ifdef RGB888
+    if (context.aggregations & AGGREGATE_WEIGHTED) {
+        cerr << "ERROR: RGB888 builds do not support weighted aggregation!" << endl;
+        exit(-1);
+    }
+#endif
+    if (context.io != "mmap" && context.io != "direct") {
+        cerr << "ERROR: unknown input method: " << context.io << endl;
         exit(-1);
     }
 
-    istringstream iss(subSampling);
-    string component;
-    for (int i = 0; getline(iss, component, ':') && i < 3; i++) {
-        if (i == 0)
-            context.J = (uint8_t) stoi(component);
-        if (i == 1)
-            context.a = (uint8_t) stoi(component);
-        if (i == 2)
-            context.b = (uint8_t) stoi(component);
-    }
-
-    // Compute Frame Size
-    int frameSize = 0;
-    if (context.J == 4) {
-        if (context.a == 4 && context.b == 4) {
-            readYUV444(context);
-        } else if (context.a == 2 && context.b == 2) {
-            // 4:2:2
-            readYUV422(context);
-        } else if (context.a == 2 && context.b == 0) {
-            // 4:2:0
-            readYUV420(context);
+    if (std::count(context.tests.begin(), context.tests.end(), string("-")) +
+            (context.ref == "-") > 1) {
+        cerr << "ERROR: only one input can be read from stdin!" << endl;
+        exit(-1);
+    }
+
+    context.roiX = context.roiY = context.roiWidth = context.roiHeight = 0;
+    if (context.pixelFormat != PIX_FMT_PLANAR && (!roi.empty() || !tile.empty())) {
+        cerr << "ERROR: --roi and --tile need --pix-fmt planar!" << endl;
+        exit(-1);
+    }
+    if (!roi.empty()) {
+        smatch m;
+        if (!regex_match(roi, m, regex("([0-9]+),([0-9]+),([0-9]+),([0-9]+)"))) {
+            cerr << "ERROR: --roi must be x,y,w,h!" << endl;
+            exit(-1);
+        }
+        context.roiX = (uint) stoul(m[1]);
+        context.roiY = (uint) stoul(m[2]);
+        context.roiWidth = (uint) stoul(m[3]);
+        context.roiHeight = (uint) stoul(m[4]);
+        if (context.roiWidth == 0 || context.roiHeight == 0 ||
+                (uint64_t) context.roiX + context.roiWidth > context.width ||
+                (uint64_t) context.roiY + context.roiHeight > context.height) {
+            cerr << "ERROR: --roi must be a non-empty rectangle inside the frame!" << endl;
+            exit(-1);
+        }
+        if (context.roiX % (1u << xShift) || context.roiY % (1u << yShift)) {
+            cerr << "ERROR: --roi origin must be a multiple of the chroma subsampling ("
+                    << (1u << xShift) << "x" << (1u << yShift) << ")!" << endl;
+            exit(-1);
+        }
+    }
+
+    context.tileWidth = context.tileHeight = 0;
+    if (!tile.empty()) {
+        smatch m;
+        if (!regex_match(tile, m, regex("([0-9]+)x([0-9]+)"))) {
+            cerr << "ERROR: --tile must be WxH!" << endl;
+            exit(-1);
+        }
+        context.tileWidth = (uint) stoul(m[1]);
+        context.tileHeight = (uint) stoul(m[2]);
+        if (context.tileWidth == 0 || context.tileHeight == 0 ||
+                context.tileWidth % (1u << xShift) || context.tileHeight % (1u << yShift)) {
+            cerr << "ERROR: --tile size must be a non-zero multiple of the chroma subsampling ("
+                    << (1u << xShift) << "x" << (1u << yShift) << ")!" << endl;
+            exit(-1);
+        }
+        if (context.tileOut.empty()) {
+            cerr << "ERROR: --tile requires --tile-out!" << endl;
+            exit(-1);
+        }
+        if (!context.cache.empty()) {
+            cerr << "ERROR: --tile cannot be combined with --cache!" << endl;
+            exit(-1);
+        }
+#ifdef RGB888
+        cerr << "ERROR: RGB888 builds do not support --tile!" << endl;
+        exit(-1);
+#endif
+    }
+
+    // Each supported layout gets its own compile-time specialization of the frame kernel. Inputs
+    // that cannot be opened or read surface as VideoInfoError from the library.
+    try {
+        if (xShift == 0 && yShift == 0) {
+            readYUV<YUV444>(context);
+        } else if (xShift == 1 && yShift == 0) {
+            readYUV<YUV422>(context);
+        } else if (xShift == 1 && yShift == 1) {
+            readYUV<YUV420>(context);
+        } else if (xShift == 2 && yShift == 0) {
+            readYUV<YUV411>(context);
+        } else if (xShift == 0 && yShift == 1) {
+            readYUV<YUV440>(context);
         } else {
-            cerr << "ERROR: unsupported sub-sampling mode! Only: 4:4:4, 4:2:2, 4:2:0." << endl;
+            cerr << "ERROR: unsupported sub-sampling mode! Only: 4:4:4, 4:2:2, 4:2:0, 4:1:1, "
+                    "4:4:0." << endl;
             exit(-1);
         }
+    } catch (const VideoInfoError& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        exit(1);
     }
 
     return SUCCESS;
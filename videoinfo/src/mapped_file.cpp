@@ -0,0 +1,71 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "videoinfo_error.h"
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) : data_(nullptr), size_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw VideoInfoError("failed to open file: " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw VideoInfoError("failed to stat file: " + path);
+    }
+    size_ = st.st_size;
+
+    if (size_ > 0) {
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            string reason = strerror(errno);
+            close(fd);
+            throw VideoInfoError("failed to mmap file: " + path + " (" + reason + ")");
+        }
+        data_ = static_cast<const uint8_t*>(addr);
+
+        // Frames are consumed front to back exactly once: read ahead aggressively and let the
+        // kernel reclaim pages behind the cursor.
+        madvise(addr, size_, MADV_SEQUENTIAL);
+    }
+
+    // The mapping holds its own reference to the file.
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+void MappedFile::randomAccess() const {
+    if (data_) {
+        madvise(const_cast<uint8_t*>(data_), size_, MADV_RANDOM);
+    }
+}
+
+void MappedFile::willNeed(size_t offset, size_t length) const {
+    if (!data_ || offset >= size_) {
+        return;
+    }
+    if (length > size_ - offset) {
+        length = size_ - offset;
+    }
+
+    // madvise() requires a page-aligned start address.
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t alignedOffset = offset & ~(pageSize - 1);
+    madvise(const_cast<uint8_t*>(data_) + alignedOffset, length + (offset - alignedOffset),
+            MADV_WILLNEED);
+}
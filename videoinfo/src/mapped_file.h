@@ -0,0 +1,56 @@
+#ifndef VIDEOINFO_MAPPED_FILE_H
+#define VIDEOINFO_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Read-only memory mapping of an entire video file.
+ *
+ * The mapping is advised as sequential so the kernel reads ahead aggressively and drops pages
+ * behind the cursor; callers hand out plane pointers directly into the mapping, so no bytes are
+ * copied and no seek/read system calls are issued per row.
+ */
+class MappedFile {
+public:
+    /**
+     * Maps a file into memory. Throws VideoInfoError if the file cannot be opened or mapped.
+     * @param[in] path the file to map.
+     */
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @return pointer to the first byte of the file, or nullptr for an empty file.
+     */
+    const uint8_t* data() const { return data_; }
+
+    /**
+     * @return the size of the file in bytes.
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * Hints to the kernel that the byte range [offset, offset + length) will be accessed soon, so
+     * it can be paged in while the current frame is being processed.
+     * @param[in] offset byte offset into the file.
+     * @param[in] length number of bytes.
+     */
+    void willNeed(size_t offset, size_t length) const;
+
+    /**
+     * Switches the mapping from sequential read-ahead to paging in only what is touched, for
+     * callers that read a small part of each frame.
+     */
+    void randomAccess() const;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+};
+
+#endif // VIDEOINFO_MAPPED_FILE_H
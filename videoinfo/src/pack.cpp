@@ -0,0 +1,148 @@
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdlib>
+
+#include "frame_container.h"
+#include "stream_reader.h"
+#include "videoinfo.h"
+#include "worker_pool.h"
+
+using namespace std;
+
+#define VERSION "0.1.0"
+
+namespace po = boost::program_options;
+
+namespace {
+
+/**
+ * @return the best codec this build supports: zstd, then lz4, then none.
+ */
+FrameCodec defaultCodec() {
+    if (codecAvailable(CODEC_ZSTD)) {
+        return CODEC_ZSTD;
+    }
+    return codecAvailable(CODEC_LZ4) ? CODEC_LZ4 : CODEC_NONE;
+}
+
+/**
+ * Packs raw frames into a container. Frames are read ahead on their own thread and compressed in
+ * batches across the pool; blocks are appended in frame order once a batch is done.
+ * @param[out] bytesWritten size of the container.
+ * @return the number of frames packed.
+ */
+size_t pack(const string& input, const string& output, size_t bytesPerFrame, FrameCodec codec,
+            int level, unsigned threads, uint64_t* bytesWritten) {
+    WorkerPool pool(threads);
+    size_t batchFrames = 4 * pool.size();
+    vector<unique_ptr<FrameCompressor>> compressors(pool.size());
+    for (auto& c : compressors) {
+        c.reset(new FrameCompressor(codec, level));
+    }
+    StreamFrameSource source(input, bytesPerFrame, 2 * batchFrames);
+    ContainerWriter writer(output, codec, level, bytesPerFrame);
+    vector<vector<uint8_t>> blocks(batchFrames);
+    vector<char> present(batchFrames);
+
+    size_t frames = 0;
+    for (bool more = true; more; ) {
+        pool.parallelFor(batchFrames, [&](size_t i) {
+            const uint8_t* frame = source.acquire(frames + i);
+            present[i] = (frame != nullptr);
+            if (frame) {
+                compressors[WorkerPool::threadIndex()]->compress(frame, bytesPerFrame, &blocks[i]);
+                source.release(frames + i);
+            }
+        });
+        for (size_t i = 0; i < batchFrames && more; i++) {
+            more = present[i];
+            if (more) {
+                writer.append(blocks[i].data(), blocks[i].size());
+                frames++;
+            }
+        }
+    }
+    writer.finish();
+    *bytesWritten = writer.bytesWritten();
+    return frames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ScorerOptions options;
+    string pixelFormat, codecName, input, output;
+    int level;
+    unsigned threads;
+
+    po::options_description desc("Options");
+    desc.add_options()
+            ("help", "Print help messages")
+            ("sampling,s",  po::value<string>(&options.sampling), "One of '4:4:4', '4:2:2', '4:2:0', '4:1:1' or '4:4:0'; required for planar input")
+            ("height,h",    po::value<uint>(&options.height)->required(), "Height of video file")
+            ("width,w",     po::value<uint>(&options.width)->required(), "Width of video file")
+            ("bitdepth",    po::value<uint>(&options.bitDepth)->default_value(8), "Bits per sample, 8 to 16")
+            ("pix-fmt",     po::value<string>(&pixelFormat)->default_value("planar"), "Frame layout, as for videoinfo")
+            ("codec",       po::value<string>(&codecName)->default_value(::codecName(defaultCodec())), "Block compression: 'zstd', 'lz4' or 'none'")
+            ("level",       po::value<int>(&level)->default_value(0), "Compression level (zstd only; default: 0 = zstd's default)")
+            ("threads,t",   po::value<unsigned>(&threads)->default_value(0), "Compression threads (default: 0 = one per core)")
+            ("input",       po::value<string>(&input)->required(), "Raw video file, pipe or '-' for stdin")
+            ("output",      po::value<string>(&output)->required(), "Container file to write");
+
+    po::positional_options_description pos;
+    pos.add("input", 1);
+    pos.add("output", 1);
+
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        if (vm.count("help")) {
+            cout << endl << "USAGE: videoinfo_pack [-s SAMPLING | --pix-fmt FORMAT] -w WIDTH"
+                    << " -h HEIGHT input output" << endl;
+            cout << endl << "    Packs raw video into a frame-indexed compressed container that"
+                    << " videoinfo reads" << endl << "    in place of the raw file." << endl;
+            cout << desc << endl << "v" << VERSION << endl;
+            return 0;
+        }
+        po::notify(vm);
+    } catch (po::error& e) {
+        cerr << "ERROR: " << e.what() << endl;
+        return 1;
+    }
+
+    FrameCodec codec;
+    if (!parseCodec(codecName, &codec)) {
+        cerr << "ERROR: unknown codec: " << codecName << endl;
+        exit(-1);
+    }
+    if (!parsePixelFormat(pixelFormat, &options.pixelFormat)) {
+        cerr << "ERROR: unknown pixel format: " << pixelFormat << endl;
+        exit(-1);
+    }
+
+    try {
+        size_t bytesPerFrame = Scorer(options).frameBytes();
+        auto start = chrono::steady_clock::now();
+        uint64_t written;
+        size_t frames = pack(input, output, bytesPerFrame, codec, level, threads, &written);
+        chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+
+        double in = (double) frames * bytesPerFrame;
+        double out = (double) written;
+        cout << "Frames: " << frames << endl;
+        cout << "Codec: " << ::codecName(codec) << endl;
+        cout << "Ratio: " << (out > 0 ? in / out : 0) << endl;
+        cout << "Throughput: " << in / seconds.count() / 1e6 << " MB/s" << endl;
+    } catch (const VideoInfoError& e) {
+        cerr << "ERROR: " << e.what() << "!" << endl;
+        exit(1);
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "prefetch_reader.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "videoinfo_error.h"
+
+using namespace std;
+
+namespace {
+
+// O_DIRECT transfers must start, end and land on logical-block boundaries; 4 KiB satisfies every
+// common block device.
+const size_t DIRECT_IO_ALIGNMENT = 4096;
+
+size_t roundUp(size_t n, size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+PrefetchFrameSource::PrefetchFrameSource(const string& path, size_t bytesPerFrame, unsigned buffers,
+                                         unsigned queueDepth, const FrameSampling& sampling,
+                                         const FrameRegion& region)
+        : path_(path), fd_(-1), direct_(true), bytesPerFrame_(bytesPerFrame), sampling_(sampling),
+          region_(region), frames_(0),
+          alignment_(DIRECT_IO_ALIGNMENT), nextRead_(0), stop_(false) {
+    fd_ = open(path.c_str(), O_RDONLY | O_DIRECT);
+    if (fd_ < 0 && errno == EINVAL) {
+        // The filesystem does not support O_DIRECT: stream through the page cache instead.
+        direct_ = false;
+        fd_ = open(path.c_str(), O_RDONLY);
+    }
+    if (fd_ < 0) {
+        throw VideoInfoError("failed to open file: " + path);
+    }
+    if (!direct_ && sampling_.step == 1 && region_.empty()) {
+        // Skipping frames defeats sequential read-ahead; leave the default heuristics then.
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close(fd_);
+        throw VideoInfoError("failed to stat file: " + path);
+    }
+    frames_ = sampling_.count(st.st_size / bytesPerFrame_);
+
+    // An unaligned frame can straddle one extra block at each end.
+    bufferBytes_ = roundUp(bytesPerFrame_, alignment_) + alignment_;
+
+    slots_.resize(buffers ? buffers : 1);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        slots_[i].buffer = nullptr;
+    }
+    for (size_t i = 0; i < slots_.size(); i++) {
+        void* p = nullptr;
+        if (posix_memalign(&p, alignment_, bufferBytes_) != 0) {
+            releaseBuffers();
+            throw VideoInfoError("failed to allocate " + to_string(slots_.size()) +
+                                 " read-ahead buffers of " + to_string(bufferBytes_) + " bytes");
+        }
+        slots_[i].buffer = static_cast<uint8_t*>(p);
+        slots_[i].data = nullptr;
+        slots_[i].frame = EMPTY;
+        slots_[i].next = i;
+        slots_[i].ready = false;
+    }
+
+    for (unsigned i = 0; i < (queueDepth ? queueDepth : 1); i++) {
+        readers_.emplace_back(&PrefetchFrameSource::readerLoop, this);
+    }
+}
+
+PrefetchFrameSource::~PrefetchFrameSource() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    slotFree_.notify_all();
+    for (auto& r : readers_) {
+        r.join();
+    }
+    releaseBuffers();
+}
+
+void PrefetchFrameSource::releaseBuffers() {
+    for (auto& s : slots_) {
+        free(s.buffer);
+    }
+    close(fd_);
+}
+
+const uint8_t* PrefetchFrameSource::acquire(size_t f) {
+    Slot& slot = slots_[f % slots_.size()];
+    unique_lock<mutex> lock(mutex_);
+    frameReady_.wait(lock, [this, &slot, f] {
+        return (slot.frame == f && slot.ready) || !error_.empty();
+    });
+    if (!(slot.frame == f && slot.ready)) {
+        throw VideoInfoError(error_);
+    }
+    return slot.data;
+}
+
+void PrefetchFrameSource::release(size_t f) {
+    Slot& slot = slots_[f % slots_.size()];
+    {
+        lock_guard<mutex> lock(mutex_);
+        slot.frame = EMPTY;
+        slot.ready = false;
+        slot.next = f + slots_.size();
+    }
+    slotFree_.notify_all();
+}
+
+void PrefetchFrameSource::readerLoop() {
+    for (;;) {
+        size_t f = nextRead_.fetch_add(1);
+        if (f >= frames_) {
+            return;
+        }
+
+        Slot& slot = slots_[f % slots_.size()];
+        {
+            // Wait for the consumer to hand back the frame that used this slot one lap earlier.
+            unique_lock<mutex> lock(mutex_);
+            slotFree_.wait(lock, [this, &slot, f] { return stop_ || slot.next == f; });
+            if (stop_) {
+                return;
+            }
+            slot.frame = f;
+        }
+
+        try {
+            readFrame(f, slot);
+        } catch (const VideoInfoError& e) {
+            // Consumers waiting for any frame wake up and rethrow.
+            {
+                lock_guard<mutex> lock(mutex_);
+                error_ = e.what();
+            }
+            frameReady_.notify_all();
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            slot.ready = true;
+        }
+        frameReady_.notify_all();
+    }
+}
+
+void PrefetchFrameSource::readFrame(size_t f, Slot& slot) {
+    size_t offset = sampling_.frame(f) * bytesPerFrame_;
+    size_t start = direct_ ? (offset & ~(alignment_ - 1)) : offset;
+    if (region_.empty()) {
+        readSpan(f, offset, bytesPerFrame_, start, slot);
+    }
+    // Only the region is read, each range into its place in the buffer; the gaps keep stale data
+    // that nothing looks at.
+    for (const ByteRange& r : region_) {
+        readSpan(f, offset + r.offset, r.length, start, slot);
+    }
+    slot.data = slot.buffer + (offset - start);
+}
+
+void PrefetchFrameSource::readSpan(size_t f, size_t offset, size_t length, size_t start,
+                                   Slot& slot) {
+    size_t begin = direct_ ? (offset & ~(alignment_ - 1)) : offset;
+    size_t needed = offset - begin + length;
+    size_t request = direct_ ? roundUp(needed, alignment_) : needed;
+    uint8_t* dst = slot.buffer + (begin - start);
+
+    size_t got = 0;
+    while (got < needed) {
+        ssize_t n = pread(fd_, dst + got, request - got, begin + got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw VideoInfoError("failed to read frame " + to_string(f) + " from file: " + path_);
+        }
+        got += n;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef VIDEOINFO_PREFETCH_READER_H
+#define VIDEOINFO_PREFETCH_READER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_source.h"
+
+/**
+ * Read-ahead pipeline for inputs that do not fit in the page cache.
+ *
+ * A pool of I/O threads reads frames front to back with O_DIRECT into a bounded ring of aligned
+ * buffers, while scoring threads consume them through acquire()/release(). Frame f lives in slot
+ * f % buffers; a reader only overwrites a slot after the frame that previously occupied it has been
+ * released, so I/O runs at most `buffers` frames ahead of compute and memory use stays bounded.
+ * Filesystems that reject O_DIRECT (e.g. tmpfs) fall back to buffered reads.
+ */
+class PrefetchFrameSource : public FrameSource {
+public:
+    /**
+     * Opens the file and starts the I/O threads. Throws VideoInfoError on failure.
+     * @param[in] path the raw video file.
+     * @param[in] bytesPerFrame size of one frame.
+     * @param[in] buffers number of frame buffers in the ring.
+     * @param[in] queueDepth number of reads kept in flight (one I/O thread each).
+     * @param[in] sampling the frames to serve; only these are read.
+     * @param[in] region the part of each frame to read; the rest of the buffer is left unset.
+     */
+    PrefetchFrameSource(const std::string& path, size_t bytesPerFrame, unsigned buffers,
+                        unsigned queueDepth, const FrameSampling& sampling = FrameSampling(),
+                        const FrameRegion& region = FrameRegion());
+    ~PrefetchFrameSource() override;
+
+    size_t frameCount() const override { return frames_; }
+    size_t maxHeldFrames() const override { return slots_.size(); }
+    const uint8_t* acquire(size_t f) override;
+    void release(size_t f) override;
+
+private:
+    struct Slot {
+        uint8_t* buffer;      // aligned allocation backing the slot
+        const uint8_t* data;  // first byte of the frame inside buffer
+        size_t frame;         // frame currently held, or EMPTY
+        size_t next;          // the only frame allowed to claim the slot next
+        bool ready;           // frame has been read and may be acquired
+    };
+
+    static const size_t EMPTY = ~(size_t) 0;
+
+    void readerLoop();
+    void readFrame(size_t f, Slot& slot);
+    void readSpan(size_t f, size_t offset, size_t length, size_t start, Slot& slot);
+    void releaseBuffers();
+
+    std::string path_;
+    int fd_;
+    bool direct_;
+    size_t bytesPerFrame_;
+    FrameSampling sampling_;
+    FrameRegion region_;
+    size_t frames_;
+    size_t alignment_;
+    size_t bufferBytes_;
+
+    std::vector<Slot> slots_;
+    std::vector<std::thread> readers_;
+    std::atomic<size_t> nextRead_;
+
+    std::mutex mutex_;
+    std::condition_variable slotFree_;
+    std::condition_variable frameReady_;
+    std::string error_;       // why a read failed, empty while all reads succeed
+    bool stop_;
+};
+
+#endif // VIDEOINFO_PREFETCH_READER_H
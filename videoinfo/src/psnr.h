@@ -0,0 +1,337 @@
+#ifndef VIDEOINFO_PSNR_H
+#define VIDEOINFO_PSNR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "frame_geometry.h"
+#include "ssd.h"
+
+typedef struct {
+    uint8_t y;
+    uint8_t u;
+    uint8_t v;
+} YCbCr;
+
+/**
+ * Sum of squared errors of one frame, per plane. With RGB888 defined the planes hold R, G and B
+ * errors computed at luma resolution.
+ */
+typedef struct FrameSSE {
+    uint64_t sse[NUM_PLANES];
+} FrameSSE;
+
+#ifdef RGB888
+/**
+ * YCbCr to RGB888
+ */
+inline void yuv2rgb(uint8_t Y, uint8_t Cb, uint8_t Cr, uint8_t *r, uint8_t *g, uint8_t *b) {
+
+    Cr = Cr - 128;
+    Cb = Cb - 128;
+
+    *r = Y + Cr + (Cr >> 2) + (Cr >> 3) + (Cr >> 5);
+    *g = Y - ((Cb >> 2) + (Cb >> 4) + (Cb >> 5)) - ((Cr >> 1) + (Cr >> 3) + (Cr >> 4) + (Cr >> 5));
+    *b = Y + Cb + (Cb >> 1) + (Cb >> 2) + (Cb >> 6);
+}
+#endif
+
+#define MAX_I(bits) ((1 << (bits)) - 1)
+#define MAX_I_8_BITS MAX_I(8)
+
+inline double psnr(double mse, uint bitDepth = 8){
+    // ------------------------------------------------------------------------------------
+    //    MAX_I = 2^B-1 where B = bits per sample; for 8-bit sampling MAX_I = 255,
+    //    for 10-bit MAX_I = 1023, for 16-bit MAX_I = 65535.
+    //
+    //    PSNR = 20*log10(MAX_I) - 10*log10(mse)
+    // ------------------------------------------------------------------------------------
+    double peak = (bitDepth == 8) ? 48.130803609 : 20*log10((double) MAX_I(bitDepth));
+    double psnr = peak - 10*log10(mse);
+    return (std::isinf(psnr)) ? 0 : psnr; // Return 0 if PSNR is infinite (i.e. 0dB)
+}
+
+/**
+ * Sum of squared errors over rows [firstRow, firstRow + rows) of one plane.
+ * @param[in] g the frame layout.
+ * @param[in] p the plane.
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tst first byte of the test frame.
+ * @param[in] firstRow first row of the band.
+ * @param[in] rows number of rows in the band.
+ * @return the SSE of the band.
+ */
+inline uint64_t planeSSE(const FrameGeometry& g, int p, const uint8_t* ref, const uint8_t* tst,
+                         uint firstRow, uint rows) {
+    const PlaneGeometry& pg = g.planes[p];
+    size_t offset = pg.offset + firstRow * pg.stride;
+    if (g.bytesPerSample == 1) {
+        return ssdPlane8(ref + offset, tst + offset, pg.width, rows, pg.stride);
+    }
+    // High bit-depth planes are little-endian 16-bit words, read in place on x86.
+    return ssdPlane16((const uint16_t*) (ref + offset), (const uint16_t*) (tst + offset), pg.width,
+                      rows, pg.stride, g.bitDepth);
+}
+
+/**
+ * @param[in] g the frame layout.
+ * @return the number of separately stored surfaces: the three planes of a planar frame, the luma
+ *         and interleaved chroma planes of NV12, NV21 and P010, or the one packed YUYV/UYVY plane.
+ */
+inline int surfaceCount(const FrameGeometry& g) {
+    switch (g.pixelFormat) {
+    case PIX_FMT_PLANAR:
+        return 3;
+    case PIX_FMT_YUYV:
+    case PIX_FMT_UYVY:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+/**
+ * @param[in] g the frame layout.
+ * @param[in] s the surface.
+ * @param[out] first first plane stored in the surface.
+ * @param[out] last last plane stored in the surface.
+ */
+inline void surfacePlanes(const FrameGeometry& g, int s, int* first, int* last) {
+    int surfaces = surfaceCount(g);
+    if (surfaces == 1) {
+        *first = PLANE_Y;
+        *last = PLANE_V;
+    } else {
+        *first = s;
+        *last = (surfaces == 3 || s == 0) ? s : PLANE_V;
+    }
+}
+
+/**
+ * Adds the sum of squared errors over rows [firstRow, firstRow + rows) of one surface to the
+ * totals of the planes stored in it.
+ * @param[in] g the frame layout.
+ * @param[in] s the surface, below surfaceCount(g).
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tst first byte of the test frame.
+ * @param[in] firstRow first row of the band.
+ * @param[in] rows number of rows in the band.
+ * @param[in,out] e the per-plane SSE.
+ */
+inline void surfaceSSE(const FrameGeometry& g, int s, const uint8_t* ref, const uint8_t* tst,
+                       uint firstRow, uint rows, FrameSSE* e) {
+    int first, last;
+    surfacePlanes(g, s, &first, &last);
+    const PlaneGeometry& pg = g.planes[first];
+    if (first == last && pg.step == 1 && g.sampleShift == 0) {
+        e->sse[first] += planeSSE(g, first, ref, tst, firstRow, rows);
+        return;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // OPTIMIZATION:
+    //
+    // Interleaved samples are never split into planes. The kernels walk the surface rows as they
+    // are stored and keep one total per sample position within a group of 4 (8-bit) or 2 (16-bit)
+    // samples; every position belongs to exactly one plane, so the totals are routed afterwards.
+    //----------------------------------------------------------------------------------------------
+    size_t base = pg.offset;
+    for (int p = first; p <= last; p++) {
+        base = std::min(base, g.planes[p].offset);
+    }
+    size_t offset = base + firstRow * pg.stride;
+    uint width = (uint) (pg.stride / g.bytesPerSample);
+    uint64_t sums[4];
+    uint period;
+    if (g.bytesPerSample == 1) {
+        ssdInterleaved8(ref + offset, tst + offset, width, rows, pg.stride, sums);
+        period = 4;
+    } else {
+        ssdInterleaved16((const uint16_t*) (ref + offset), (const uint16_t*) (tst + offset), width,
+                         rows, pg.stride, g.bitDepth, g.sampleShift, sums);
+        period = 2;
+    }
+    for (int p = first; p <= last; p++) {
+        uint position = (uint) ((g.planes[p].offset - base) / g.bytesPerSample);
+        for (uint c = position; c < period; c += g.planes[p].step) {
+            e->sse[p] += sums[c];
+        }
+    }
+}
+
+/**
+ * Computes the per-plane sum of squared errors between a reference and a test frame.
+ *
+ * The kernel is specialized per subsampling scheme S (see Subsampling<>), so plane sizes and the
+ * luma-to-chroma coordinate mapping are resolved at compile time and the inner loops carry no
+ * per-pixel branches.
+ *
+ * @param[in] g the frame layout, built by S::geometry().
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tst first byte of the test frame.
+ * @return the per-plane SSE.
+ */
+template <class S>
+FrameSSE frameSSE(const FrameGeometry& g, const uint8_t* ref, const uint8_t* tst) {
+    FrameSSE result = {{0, 0, 0}};
+#ifdef RGB888
+    const PlaneGeometry& py = g.planes[PLANE_Y];
+    const PlaneGeometry& pu = g.planes[PLANE_U];
+    const PlaneGeometry& pv = g.planes[PLANE_V];
+
+    for (uint y = 0; y < py.height; ++y) {
+        const uint8_t* rYRow = ref + py.offset + y * py.stride;
+        const uint8_t* rURow = ref + pu.offset + (y >> S::yShift) * pu.stride;
+        const uint8_t* rVRow = ref + pv.offset + (y >> S::yShift) * pv.stride;
+        const uint8_t* tYRow = tst + py.offset + y * py.stride;
+        const uint8_t* tURow = tst + pu.offset + (y >> S::yShift) * pu.stride;
+        const uint8_t* tVRow = tst + pv.offset + (y >> S::yShift) * pv.stride;
+
+        for (uint x = 0; x < py.width; ++x) {
+            uint8_t rr, rg, rb;
+            uint8_t tr, tg, tb;
+
+            yuv2rgb(rYRow[x], rURow[x >> S::xShift], rVRow[x >> S::xShift], &rr, &rg, &rb);
+            yuv2rgb(tYRow[x], tURow[x >> S::xShift], tVRow[x >> S::xShift], &tr, &tg, &tb);
+
+            result.sse[0] += (rr - tr) * (rr - tr);
+            result.sse[1] += (rg - tg) * (rg - tg);
+            result.sse[2] += (rb - tb) * (rb - tb);
+        }
+    }
+#else
+    //----------------------------------------------------------------------------------------------
+    // OPTIMIZATION:
+    //
+    // Each plane is scored at its native resolution. A chroma sample shared by N luma samples
+    // contributes N times its squared error over N times as many samples, so scoring it once is
+    // exact and avoids replicating chroma bytes. Whole planes go to the SIMD kernel picked at
+    // startup, which walks each row contiguously.
+    //----------------------------------------------------------------------------------------------
+    for (int s = 0; s < surfaceCount(g); s++) {
+        int first, last;
+        surfacePlanes(g, s, &first, &last);
+        surfaceSSE(g, s, ref, tst, 0, g.planes[first].height, &result);
+    }
+#endif
+    return result;
+}
+
+/**
+ * Scores one reference frame against the same frame of several test videos.
+ * @param[in] g the frame layout, built by S::geometry().
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tsts first byte of each test frame; nullptr entries are skipped.
+ * @param[in] count number of test frames.
+ * @param[out] results per-plane SSE for each test frame; left untouched for skipped entries.
+ */
+template <class S>
+void frameSSE(const FrameGeometry& g, const uint8_t* ref, const uint8_t* const* tsts, size_t count,
+              FrameSSE* results) {
+#ifdef RGB888
+    for (size_t i = 0; i < count; i++) {
+        if (tsts[i]) {
+            results[i] = frameSSE<S>(g, ref, tsts[i]);
+        }
+    }
+#else
+    //----------------------------------------------------------------------------------------------
+    // OPTIMIZATION:
+    //
+    // Walk each surface in bands sized to stay resident in L2 and score every test against a band
+    // before moving on, so the reference is fetched from memory once instead of once per test.
+    //----------------------------------------------------------------------------------------------
+    const size_t BAND_BYTES = 256 << 10;
+    for (size_t i = 0; i < count; i++) {
+        if (tsts[i]) {
+            results[i] = FrameSSE{{0, 0, 0}};
+        }
+    }
+    for (int s = 0; s < surfaceCount(g); s++) {
+        int first, last;
+        surfacePlanes(g, s, &first, &last);
+        const PlaneGeometry& pg = g.planes[first];
+        uint bandRows = (uint) std::max((size_t) 1, BAND_BYTES / pg.stride);
+        for (uint y = 0; y < pg.height; y += bandRows) {
+            uint rows = std::min(bandRows, pg.height - y);
+            for (size_t i = 0; i < count; i++) {
+                if (tsts[i]) {
+                    surfaceSSE(g, s, ref, tsts[i], y, rows, &results[i]);
+                }
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * @param[in] g the frame layout.
+ * @param[in] p the plane.
+ * @return the number of samples of plane p that errors are measured over.
+ */
+inline size_t planeSamples(const FrameGeometry& g, int p) {
+#ifdef RGB888
+    // R, G, B are reconstructed at luma resolution.
+    return g.planes[PLANE_Y].samples();
+#else
+    return g.planes[p].samples();
+#endif
+}
+
+/**
+ * @param[in] g the frame layout.
+ * @param[in] e the per-plane SSE of the frame.
+ * @param[in] p the plane.
+ * @return the mean squared error of plane p.
+ */
+inline double planeMSE(const FrameGeometry& g, const FrameSSE& e, int p) {
+    return (double) e.sse[p] / planeSamples(g, p);
+}
+
+/**
+ * @param[in] p the plane.
+ * @return the short name of plane p, as used in reports.
+ */
+inline const char* planeName(int p) {
+#ifdef RGB888
+    static const char* names[NUM_PLANES] = { "r", "g", "b" };
+#else
+    static const char* names[NUM_PLANES] = { "y", "u", "v" };
+#endif
+    return names[p];
+}
+
+/**
+ * Aggregates per-plane errors into a frame score: the average of the per-plane PSNRs.
+ * @param[in] g the frame layout.
+ * @param[in] e the per-plane SSE of the frame.
+ * @return the frame score in dB.
+ */
+inline double frameScore(const FrameGeometry& g, const FrameSSE& e) {
+    double score = 0;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        score += psnr(planeMSE(g, e, p), g.bitDepth);
+    }
+    return score / NUM_PLANES;
+}
+
+/**
+ * Kahan-compensated running sum. Sequence scores add one value per frame, and over hundreds of
+ * thousands of frames plain double accumulation starts dropping the low-order bits of each term.
+ */
+typedef struct KahanSum {
+    double sum = 0;
+    double compensation = 0;
+
+    void add(double value) {
+        double y = value - compensation;
+        double t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+
+    double value() const { return sum; }
+} KahanSum;
+
+#endif // VIDEOINFO_PSNR_H
@@ -0,0 +1,167 @@
+#include "run_stats.h"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+double seconds(RunStats::Clock::duration d) {
+    return chrono::duration<double>(d).count();
+}
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        fds_[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (fds_[i] >= 0) {
+            close(fds_[i]);
+        }
+    }
+#endif
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+    static const uint64_t configs[NUM_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.inherit = 1;        // count the worker threads too
+        attr.exclude_kernel = 1; // allowed at the default perf_event_paranoid level
+        attr.exclude_hv = 1;
+        fds_[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+bool PerfCounters::read(Counter counter, uint64_t* value) const {
+#ifdef __linux__
+    return fds_[counter] >= 0 && ::read(fds_[counter], value, sizeof(*value)) == sizeof(*value);
+#else
+    return false;
+#endif
+}
+
+const char* PerfCounters::name(Counter counter) {
+    switch (counter) {
+    case CYCLES:
+        return "cycles";
+    case INSTRUCTIONS:
+        return "instructions";
+    case CACHE_REFERENCES:
+        return "cache references";
+    case CACHE_MISSES:
+        return "cache misses";
+    default:
+        return "unknown";
+    }
+}
+
+RunStats::RunStats(unsigned threads)
+        : threads_(nullptr, free), numThreads_(threads ? threads : 1), aggregation_(0),
+          bytes_(0) {
+    void* p = nullptr;
+    if (posix_memalign(&p, CACHE_LINE, numThreads_ * sizeof(ThreadStats)) != 0) {
+        throw bad_alloc();
+    }
+    threads_.reset(static_cast<ThreadStats*>(p));
+    for (size_t i = 0; i < numThreads_; i++) {
+        ThreadStats& t = threads_.get()[i];
+        t.read = t.fingerprint = t.kernel = Clock::duration(0);
+        t.frames = 0;
+    }
+}
+
+void RunStats::print(ostream& out, Clock::duration wall, const PerfCounters* perf) const {
+    Clock::duration read(0), fingerprint(0), kernel(0);
+    for (size_t i = 0; i < numThreads_; i++) {
+        const ThreadStats& t = threads_.get()[i];
+        read += t.read;
+        fingerprint += t.fingerprint;
+        kernel += t.kernel;
+    }
+    double wallSeconds = seconds(wall);
+    double threadSeconds = wallSeconds * numThreads_;
+
+    char line[256];
+    out << "Stats:" << endl;
+    snprintf(line, sizeof(line), "  Wall time:        %10.3f s", wallSeconds);
+    out << line << endl;
+    // Read and kernel time are summed over threads, so they are shown against wall x threads.
+    snprintf(line, sizeof(line), "  Read wait:        %10.3f s (%5.1f%% of thread time)",
+             seconds(read), 100 * seconds(read) / threadSeconds);
+    out << line << endl;
+    if (fingerprint.count()) {
+        snprintf(line, sizeof(line), "  Fingerprints:     %10.3f s (%5.1f%% of thread time)",
+                 seconds(fingerprint), 100 * seconds(fingerprint) / threadSeconds);
+        out << line << endl;
+    }
+    snprintf(line, sizeof(line), "  Kernels:          %10.3f s (%5.1f%% of thread time)",
+             seconds(kernel), 100 * seconds(kernel) / threadSeconds);
+    out << line << endl;
+    snprintf(line, sizeof(line), "  Aggregation:      %10.3f s (%5.1f%% of wall time)",
+             seconds(aggregation_), 100 * seconds(aggregation_) / wallSeconds);
+    out << line << endl;
+    snprintf(line, sizeof(line), "  Bytes read:       %10.1f MB", bytes_ / 1e6);
+    out << line << endl;
+    snprintf(line, sizeof(line), "  Bandwidth:        %10.1f MB/s", bytes_ / 1e6 / wallSeconds);
+    out << line << endl;
+
+    for (size_t i = 0; i < numThreads_; i++) {
+        const ThreadStats& t = threads_.get()[i];
+        double r = 100 * seconds(t.read) / wallSeconds;
+        double h = 100 * seconds(t.fingerprint) / wallSeconds;
+        double k = 100 * seconds(t.kernel) / wallSeconds;
+        if (fingerprint.count()) {
+            snprintf(line, sizeof(line),
+                     "  Thread %-3zu        busy %5.1f%% (read %5.1f%%, fingerprints %5.1f%%, "
+                     "kernels %5.1f%%), %llu frames scored",
+                     i, r + h + k, r, h, k, (unsigned long long) t.frames);
+        } else {
+            snprintf(line, sizeof(line),
+                     "  Thread %-3zu        busy %5.1f%% (read %5.1f%%, kernels %5.1f%%), "
+                     "%llu frames",
+                     i, r + k, r, k, (unsigned long long) t.frames);
+        }
+        out << line << endl;
+    }
+
+    if (!perf) {
+        return;
+    }
+    bool any = false;
+    for (int i = 0; i < PerfCounters::NUM_COUNTERS; i++) {
+        uint64_t value;
+        if (perf->read((PerfCounters::Counter) i, &value)) {
+            snprintf(line, sizeof(line), "  %-18s%14llu",
+                     PerfCounters::name((PerfCounters::Counter) i), (unsigned long long) value);
+            out << line << endl;
+            any = true;
+        }
+    }
+    if (!any) {
+        out << "  perf_event counters unavailable" << endl;
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef VIDEOINFO_RUN_STATS_H
+#define VIDEOINFO_RUN_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <ostream>
+
+/**
+ * Hardware counters for the whole process, read through Linux perf_event. Threads created after
+ * start() are included once they exit, so read() must come after the worker pool is destroyed.
+ * Silently unavailable when the kernel or sandbox does not permit perf_event_open.
+ */
+class PerfCounters {
+public:
+    enum Counter { CYCLES, INSTRUCTIONS, CACHE_REFERENCES, CACHE_MISSES, NUM_COUNTERS };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * Opens and enables the counters.
+     */
+    void start();
+
+    /**
+     * @param[in] counter the counter.
+     * @param[out] value its count since start().
+     * @return false if the counter could not be opened or read.
+     */
+    bool read(Counter counter, uint64_t* value) const;
+
+    /**
+     * @param[in] counter the counter.
+     * @return a printable name for the counter.
+     */
+    static const char* name(Counter counter);
+
+private:
+    int fds_[NUM_COUNTERS];
+};
+
+/**
+ * Where time goes in a scoring run, gathered with steady_clock around each stage.
+ *
+ * Workers record into their own slot (indexed by WorkerPool::threadIndex()), so recording takes no
+ * locks. Slots are one cache line each in a line-aligned buffer, so threads never share a line.
+ * Aggregation runs on the main thread.
+ */
+class RunStats {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @param[in] threads number of threads in the worker pool.
+     */
+    explicit RunStats(unsigned threads);
+
+    /**
+     * Records a worker waiting for frame data, whether or not the frame is scored afterwards.
+     * @param[in] thread the WorkerPool::threadIndex() of the worker.
+     * @param[in] read time spent waiting for the frame data.
+     */
+    void addRead(unsigned thread, Clock::duration read) { threads_.get()[thread].read += read; }
+
+    /**
+     * Records a worker checking one frame against the --cache.
+     * @param[in] thread the WorkerPool::threadIndex() of the worker.
+     * @param[in] fingerprint time spent hashing the frames and looking up their entries.
+     */
+    void addFingerprint(unsigned thread, Clock::duration fingerprint) {
+        threads_.get()[thread].fingerprint += fingerprint;
+    }
+
+    /**
+     * Records one frame scored by a worker; frames served entirely from the cache are not.
+     * @param[in] thread the WorkerPool::threadIndex() of the worker.
+     * @param[in] kernel time spent in the metric kernels.
+     */
+    void addFrame(unsigned thread, Clock::duration kernel) {
+        ThreadStats& t = threads_.get()[thread];
+        t.kernel += kernel;
+        t.frames++;
+    }
+
+    /**
+     * Records time spent reducing results on the main thread.
+     * @param[in] aggregation the elapsed time.
+     */
+    void addAggregation(Clock::duration aggregation) { aggregation_ += aggregation; }
+
+    /**
+     * Records frame data handed to the kernels.
+     * @param[in] bytes number of bytes.
+     */
+    void addBytes(uint64_t bytes) { bytes_ += bytes; }
+
+    /**
+     * Prints the breakdown.
+     * @param[in] out the stream.
+     * @param[in] wall elapsed time of the whole scoring loop.
+     * @param[in] perf hardware counters, or nullptr.
+     */
+    void print(std::ostream& out, Clock::duration wall, const PerfCounters* perf) const;
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    struct ThreadStats {
+        Clock::duration read;
+        Clock::duration fingerprint;
+        Clock::duration kernel;
+        uint64_t frames;
+        char pad[CACHE_LINE - 3 * sizeof(Clock::duration) - sizeof(uint64_t)];
+    };
+    static_assert(sizeof(ThreadStats) == CACHE_LINE, "ThreadStats must fill one cache line");
+
+    // posix_memalign()ed, since neither new nor std::vector honours cache-line alignment in C++11.
+    std::unique_ptr<ThreadStats, void (*)(void*)> threads_;
+    size_t numThreads_;
+    Clock::duration aggregation_;
+    uint64_t bytes_;
+};
+
+#endif // VIDEOINFO_RUN_STATS_H
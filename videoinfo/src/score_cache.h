@@ -0,0 +1,128 @@
+#ifndef VIDEOINFO_SCORE_CACHE_H
+#define VIDEOINFO_SCORE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_source.h"
+#include "psnr.h"
+#include "ssim.h"
+
+/**
+ * Cached results of one reference frame scored against one test frame.
+ */
+typedef struct CacheEntry {
+    uint64_t refHash;            // fingerprint of the reference frame the result came from
+    uint64_t testHash;           // fingerprint of the test frame the result came from
+    uint32_t metrics;            // Metric mask of the results held
+    FrameSSE e;
+    FrameSSIM q;
+} CacheEntry;
+
+/**
+ * Identifies one version of an input file without reading it.
+ */
+typedef struct FileStamp {
+    uint64_t size;               // ~0 for streams and missing files
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime;               // nanoseconds, 0 if too recent to tell later writes apart
+} FileStamp;
+
+/**
+ * Sidecar file of per-frame results (--cache), so re-scoring a pair after a re-run or after frames
+ * were appended to a growing capture only scores the frames that are new or changed.
+ *
+ * Entries are keyed by test video and reference frame index, and carry the fingerprints of both
+ * frames they were computed from; an entry is only reused while both fingerprints still match.
+ * A fingerprint hashes every scored byte of a frame, so any change to what the kernels would read
+ * invalidates the entry; a cached frame still costs a full read, but no scoring.
+ * The size, inode and modification time of each input are kept too. While they all still match,
+ * the input was not touched and its entries are reused without reading or hashing it. An input
+ * that shrank was rewritten rather than appended to, and all of its entries are dropped.
+ *
+ * The file is a native-endian binary dump guarded by a header holding everything the results
+ * depend on (frame layout, region, test offset, entry size, reference path); a mismatched or
+ * unreadable cache is ignored with a warning and rewritten.
+ */
+class ScoreCache {
+public:
+    /**
+     * Loads the cache file if it exists and matches.
+     * @param[in] path the cache file.
+     * @param[in] layout description of every option the results depend on.
+     * @param[in] ref the reference video.
+     * @param[in] tests the test videos.
+     */
+    ScoreCache(const std::string& path, const std::string& layout, const std::string& ref,
+               const std::vector<std::string>& tests);
+
+    ScoreCache(const ScoreCache&) = delete;
+    ScoreCache& operator=(const ScoreCache&) = delete;
+
+    /**
+     * @param[in] test index of the test video.
+     * @param[in] frame reference frame index.
+     * @return the cached entry, or nullptr. Safe to call from several threads while nothing is
+     *         being stored.
+     */
+    const CacheEntry* find(size_t test, size_t frame) const;
+
+    /**
+     * @param[in] test index of the test video.
+     * @return true if neither the reference nor the test video changed since the cache was
+     *         written, so its entries hold without checking their fingerprints.
+     */
+    bool unchanged(size_t test) const { return refUnchanged_ && tests_[test].unchanged; }
+
+    /**
+     * @param[in] test index of the test video.
+     * @param[in] frame reference frame index.
+     * @param[in] entry the results, replacing any cached ones.
+     */
+    void store(size_t test, size_t frame, const CacheEntry& entry);
+
+    /**
+     * Writes the cache next to its final path and renames it into place, so an interrupted run
+     * never leaves a truncated cache behind. Prints a warning on failure.
+     */
+    void save() const;
+
+    /**
+     * Picks the bytes of a frame that its fingerprint covers.
+     * @param[in] scored the region of the frame that is scored; empty means the whole frame.
+     * @param[in] bytesPerFrame size of one frame.
+     * @return the fingerprint region: every scored byte.
+     */
+    static FrameRegion fingerprintRegion(const FrameRegion& scored, size_t bytesPerFrame);
+
+    /**
+     * @param[in] frame first byte of the frame.
+     * @param[in] region the fingerprint region, from fingerprintRegion().
+     * @return the 64-bit fingerprint of the frame.
+     */
+    static uint64_t fingerprint(const uint8_t* frame, const FrameRegion& region);
+
+private:
+    struct TestEntries {
+        std::string path;
+        FileStamp stamp;
+        bool unchanged;          // stamp matches the one loaded from the cache
+        std::unordered_map<uint64_t, CacheEntry> entries;
+    };
+
+    bool load();
+
+    std::string path_;
+    std::string layout_;
+    std::string ref_;
+    FileStamp refStamp_;
+    bool refUnchanged_;
+    std::vector<TestEntries> tests_;
+    std::vector<TestEntries> others_;   // loaded entries of tests not in this run, kept on save
+};
+
+#endif // VIDEOINFO_SCORE_CACHE_H
@@ -0,0 +1,59 @@
+#include "sequence_score.h"
+
+#include <sstream>
+
+using namespace std;
+
+bool parseAggregations(const string& list, unsigned* modes) {
+    *modes = 0;
+    istringstream iss(list);
+    string name;
+    while (getline(iss, name, ',')) {
+        if (name == "mean") {
+            *modes |= AGGREGATE_MEAN;
+        } else if (name == "weighted") {
+            *modes |= AGGREGATE_WEIGHTED;
+        } else if (name == "global") {
+            *modes |= AGGREGATE_GLOBAL;
+        } else {
+            return false;
+        }
+    }
+    return *modes != 0;
+}
+
+SequenceScore::SequenceScore(const FrameGeometry& g) : g_(g) {
+}
+
+SequenceSummary SequenceScore::summarize() const {
+    SequenceSummary s = {};
+    if (frames_.empty()) {
+        return s;
+    }
+
+    // SSE totals can pass 2^64 for long high bit depth sequences, so they are summed as doubles.
+    KahanSum mean, weighted;
+    KahanSum total[NUM_PLANES];
+    for (const FrameSSE& e : frames_) {
+        double db[NUM_PLANES];
+        for (int p = 0; p < NUM_PLANES; p++) {
+            db[p] = psnr(planeMSE(g_, e, p), g_.bitDepth);
+            total[p].add((double) e.sse[p]);
+        }
+        mean.add((db[PLANE_Y] + db[PLANE_U] + db[PLANE_V]) / NUM_PLANES);
+        weighted.add((6 * db[PLANE_Y] + db[PLANE_U] + db[PLANE_V]) / 8);
+    }
+
+    size_t n = frames_.size();
+    s.mean = mean.value() / n;
+    s.weighted = weighted.value() / n;
+    double allSSE = 0, allSamples = 0;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        double samples = (double) n * planeSamples(g_, p);
+        s.global[p] = psnr(total[p].value() / samples, g_.bitDepth);
+        allSSE += total[p].value();
+        allSamples += samples;
+    }
+    s.globalAll = psnr(allSSE / allSamples, g_.bitDepth);
+    return s;
+}
@@ -0,0 +1,75 @@
+#ifndef VIDEOINFO_SEQUENCE_SCORE_H
+#define VIDEOINFO_SEQUENCE_SCORE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "frame_geometry.h"
+#include "psnr.h"
+
+/**
+ * Ways of turning per-frame PSNR into a sequence score, selectable with --aggregate; combined as a
+ * bit mask.
+ */
+enum Aggregation {
+    AGGREGATE_MEAN = 1 << 0,     // mean over frames of the plain Y/U/V average
+    AGGREGATE_WEIGHTED = 1 << 1, // mean over frames of (6 Y + U + V) / 8
+    AGGREGATE_GLOBAL = 1 << 2    // per-plane PSNR of the MSE over all frames (x264, ffmpeg)
+};
+
+/**
+ * Parses a comma-separated --aggregate list such as "mean,global".
+ * @param[in] list the mode names: "mean", "weighted" and "global".
+ * @param[out] modes the selected modes as an Aggregation mask.
+ * @return false if the list is empty or names an unknown mode.
+ */
+bool parseAggregations(const std::string& list, unsigned* modes);
+
+/**
+ * Sequence scores of one test video, in every aggregation mode.
+ */
+typedef struct SequenceSummary {
+    double mean;                 // AGGREGATE_MEAN, in dB
+    double weighted;             // AGGREGATE_WEIGHTED, in dB
+    double global[NUM_PLANES];   // AGGREGATE_GLOBAL per plane, in dB
+    double globalAll;            // AGGREGATE_GLOBAL over the samples of all planes, in dB
+} SequenceSummary;
+
+/**
+ * Collects the per-plane SSE of every scored frame of one test video and aggregates them into
+ * sequence scores.
+ *
+ * Frames are kept as their raw SSE, 24 bytes each, rather than as dB values, so every mode is
+ * derived from the same data in one pass at the end: averaging dB values and averaging errors give
+ * different answers, and only the errors allow both.
+ */
+class SequenceScore {
+public:
+    /**
+     * @param[in] g the frame layout that is scored, used to turn SSE into MSE.
+     */
+    explicit SequenceScore(const FrameGeometry& g);
+
+    /**
+     * Adds the next frame.
+     * @param[in] e the per-plane SSE of the frame.
+     */
+    void add(const FrameSSE& e) { frames_.push_back(e); }
+
+    /**
+     * @return the number of frames added.
+     */
+    size_t frames() const { return frames_.size(); }
+
+    /**
+     * @return the sequence scores of the frames added so far, all 0 if there are none.
+     */
+    SequenceSummary summarize() const;
+
+private:
+    FrameGeometry g_;
+    std::vector<FrameSSE> frames_;
+};
+
+#endif // VIDEOINFO_SEQUENCE_SCORE_H
@@ -0,0 +1,250 @@
+#include "ssd.h"
+
+namespace {
+
+bool cpuSupports(SimdLevel level) {
+#ifdef VIDEOINFO_X86
+    __builtin_cpu_init();
+    switch (level) {
+    case SIMD_SCALAR:
+        return true;
+    case SIMD_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SIMD_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case SIMD_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512vl");
+    default:
+        return false;
+    }
+#else
+    return level == SIMD_SCALAR;
+#endif
+}
+
+/**
+ * Rows that abut in memory form one long run: present them to the kernels as a single row, so the
+ * vector loops cross row boundaries and only the end of the plane takes the scalar tail. Kernels
+ * that tell samples apart by position need rows that are a whole number of `period` samples, so
+ * every row starts on the same component.
+ */
+void collapseRows(uint* width, uint* height, size_t* stride, size_t bytesPerSample,
+                  uint period = 1) {
+    if (*height > 1 && *stride == *width * bytesPerSample && *width % period == 0 &&
+        (uint64_t) *width * *height <= UINT32_MAX) {
+        *width *= *height;
+        *stride = *width * bytesPerSample;
+        *height = 1;
+    }
+}
+
+} // namespace
+
+uint64_t ssdPlane8Scalar(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride) {
+    // 65536 squared 8-bit errors always fit a 32-bit partial sum.
+    const uint CHUNK = 65536;
+    uint64_t sum = 0;
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        for (uint x = 0; x < width;) {
+            uint end = (width - x > CHUNK) ? x + CHUNK : width;
+            uint32_t partial = 0;
+            for (; x < end; ++x) {
+                int d = rRow[x] - tRow[x];
+                partial += d * d;
+            }
+            sum += partial;
+        }
+    }
+    return sum;
+}
+
+uint64_t ssdPlane16Scalar(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth) {
+    const uint32_t mask = (1u << bitDepth) - 1;
+    uint64_t sum = 0;
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        for (uint x = 0; x < width; ++x) {
+            int64_t d = (int64_t) (rRow[x] & mask) - (tRow[x] & mask);
+            sum += d * d;
+        }
+    }
+    return sum;
+}
+
+void ssdInterleaved8Scalar(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                           size_t stride, uint64_t* sums) {
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        for (uint x = 0; x < width; ++x) {
+            int d = rRow[x] - tRow[x];
+            s[x & 3] += d * d;
+        }
+    }
+    for (int c = 0; c < 4; c++) {
+        sums[c] = s[c];
+    }
+}
+
+void ssdInterleaved16Scalar(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                            size_t stride, uint bitDepth, uint shift, uint64_t* sums) {
+    const uint32_t mask = (1u << bitDepth) - 1;
+    uint64_t s[2] = { 0, 0 };
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        for (uint x = 0; x < width; ++x) {
+            int64_t d = (int64_t) ((rRow[x] >> shift) & mask) - ((tRow[x] >> shift) & mask);
+            s[x & 1] += d * d;
+        }
+    }
+    sums[0] = s[0];
+    sums[1] = s[1];
+}
+
+SsdPlane8Fn ssdPlane8Kernel(SimdLevel level) {
+    switch (level) {
+    case SIMD_SCALAR:
+        return ssdPlane8Scalar;
+#ifdef VIDEOINFO_X86
+    case SIMD_SSE2:
+        return ssdPlane8SSE2;
+    case SIMD_AVX2:
+        return ssdPlane8AVX2;
+    case SIMD_AVX512:
+        return ssdPlane8AVX512;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+SsdPlane16Fn ssdPlane16Kernel(SimdLevel level) {
+    switch (level) {
+    case SIMD_SCALAR:
+        return ssdPlane16Scalar;
+#ifdef VIDEOINFO_X86
+    case SIMD_SSE2:
+        return ssdPlane16SSE2;
+    case SIMD_AVX2:
+        return ssdPlane16AVX2;
+    case SIMD_AVX512:
+        return ssdPlane16AVX512;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+SsdInterleaved8Fn ssdInterleaved8Kernel(SimdLevel level) {
+    switch (level) {
+    case SIMD_SCALAR:
+        return ssdInterleaved8Scalar;
+#ifdef VIDEOINFO_X86
+    case SIMD_SSE2:
+        return ssdInterleaved8SSE2;
+    case SIMD_AVX2:
+        return ssdInterleaved8AVX2;
+    case SIMD_AVX512:
+        return ssdInterleaved8AVX512;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+SsdInterleaved16Fn ssdInterleaved16Kernel(SimdLevel level) {
+    switch (level) {
+    case SIMD_SCALAR:
+        return ssdInterleaved16Scalar;
+#ifdef VIDEOINFO_X86
+    case SIMD_SSE2:
+        return ssdInterleaved16SSE2;
+    case SIMD_AVX2:
+        return ssdInterleaved16AVX2;
+    case SIMD_AVX512:
+        return ssdInterleaved16AVX512;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+SimdLevel detectSimdLevel() {
+    for (int level = NUM_SIMD_LEVELS - 1; level > SIMD_SCALAR; level--) {
+        if (ssdPlane8Kernel((SimdLevel) level) && cpuSupports((SimdLevel) level)) {
+            return (SimdLevel) level;
+        }
+    }
+    return SIMD_SCALAR;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SIMD_SCALAR:
+        return "scalar";
+    case SIMD_SSE2:
+        return "sse2";
+    case SIMD_AVX2:
+        return "avx2";
+    case SIMD_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+namespace {
+
+// Resolved once during static initialization, before any worker can call the kernels.
+SimdLevel g_level = detectSimdLevel();
+SsdPlane8Fn g_ssdPlane8 = ssdPlane8Kernel(g_level);
+SsdPlane16Fn g_ssdPlane16 = ssdPlane16Kernel(g_level);
+SsdInterleaved8Fn g_ssdInterleaved8 = ssdInterleaved8Kernel(g_level);
+SsdInterleaved16Fn g_ssdInterleaved16 = ssdInterleaved16Kernel(g_level);
+
+} // namespace
+
+SimdLevel setSimdLevel(SimdLevel level) {
+    SimdLevel best = detectSimdLevel();
+    g_level = (level > best) ? best : level;
+    g_ssdPlane8 = ssdPlane8Kernel(g_level);
+    g_ssdPlane16 = ssdPlane16Kernel(g_level);
+    g_ssdInterleaved8 = ssdInterleaved8Kernel(g_level);
+    g_ssdInterleaved16 = ssdInterleaved16Kernel(g_level);
+    return g_level;
+}
+
+SimdLevel currentSimdLevel() {
+    return g_level;
+}
+
+uint64_t ssdPlane8(const uint8_t* ref, const uint8_t* tst, uint width, uint height, size_t stride) {
+    collapseRows(&width, &height, &stride, 1);
+    return g_ssdPlane8(ref, tst, width, height, stride);
+}
+
+uint64_t ssdPlane16(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                    size_t stride, uint bitDepth) {
+    collapseRows(&width, &height, &stride, 2);
+    return g_ssdPlane16(ref, tst, width, height, stride, bitDepth);
+}
+
+void ssdInterleaved8(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                     size_t stride, uint64_t* sums) {
+    collapseRows(&width, &height, &stride, 1, 4);
+    g_ssdInterleaved8(ref, tst, width, height, stride, sums);
+}
+
+void ssdInterleaved16(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                      size_t stride, uint bitDepth, uint shift, uint64_t* sums) {
+    collapseRows(&width, &height, &stride, 2, 2);
+    g_ssdInterleaved16(ref, tst, width, height, stride, bitDepth, shift, sums);
+}
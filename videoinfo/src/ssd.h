@@ -0,0 +1,193 @@
+#ifndef VIDEOINFO_SSD_H
+#define VIDEOINFO_SSD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+
+/**
+ * Instruction set used by the sum-of-squared-differences kernels.
+ */
+enum SimdLevel { SIMD_SCALAR = 0, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512, NUM_SIMD_LEVELS };
+
+/**
+ * Sum of squared differences over a width x height plane of 8-bit samples.
+ * @param[in] ref first sample of the reference plane.
+ * @param[in] tst first sample of the test plane.
+ * @param[in] width samples per row.
+ * @param[in] height number of rows.
+ * @param[in] stride bytes between the start of consecutive rows (same for both planes).
+ * @return the sum over all samples of (ref - tst)^2.
+ */
+typedef uint64_t (*SsdPlane8Fn)(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                                size_t stride);
+
+/**
+ * Sum of squared differences over a width x height plane of 9- to 16-bit samples stored in 16-bit
+ * words. Only the low bitDepth bits of each word are compared, which bounds every squared error by
+ * (2^bitDepth - 1)^2 and lets the kernels size their 32-bit lane flush interval per depth.
+ * @param[in] ref first sample of the reference plane.
+ * @param[in] tst first sample of the test plane.
+ * @param[in] width samples per row.
+ * @param[in] height number of rows.
+ * @param[in] stride bytes between the start of consecutive rows (same for both planes).
+ * @param[in] bitDepth significant bits per sample, at most 16.
+ * @return the sum over all samples of (ref - tst)^2.
+ */
+typedef uint64_t (*SsdPlane16Fn)(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                                 size_t stride, uint bitDepth);
+
+/**
+ * Sums of squared differences over a width x height surface of interleaved 8-bit samples (packed
+ * YUYV/UYVY rows, or the UV plane of NV12/NV21), kept apart by sample position so each component
+ * gets its own total without first splitting the samples into planes.
+ * @param[in] ref first sample of the reference surface.
+ * @param[in] tst first sample of the test surface.
+ * @param[in] width samples per row.
+ * @param[in] height number of rows.
+ * @param[in] stride bytes between the start of consecutive rows (same for both surfaces).
+ * @param[out] sums sums[c] is the sum of (ref - tst)^2 over the samples at x % 4 == c.
+ */
+typedef void (*SsdInterleaved8Fn)(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                                  size_t stride, uint64_t* sums);
+
+/**
+ * Sums of squared differences over a surface of interleaved 16-bit words (the planes of P010),
+ * kept apart by sample position. Each word holds a bitDepth-bit sample in bits
+ * [shift, shift + bitDepth); P010 keeps its 10 bits at the top of the word.
+ * @param[in] ref first sample of the reference surface.
+ * @param[in] tst first sample of the test surface.
+ * @param[in] width samples per row.
+ * @param[in] height number of rows.
+ * @param[in] stride bytes between the start of consecutive rows (same for both surfaces).
+ * @param[in] bitDepth significant bits per sample, at most 15.
+ * @param[in] shift position of the lowest significant bit.
+ * @param[out] sums sums[c] is the sum of (ref - tst)^2 over the samples at x % 2 == c.
+ */
+typedef void (*SsdInterleaved16Fn)(const uint16_t* ref, const uint16_t* tst, uint width,
+                                   uint height, size_t stride, uint bitDepth, uint shift,
+                                   uint64_t* sums);
+
+/**
+ * @return the best instruction set supported by both this build and the running CPU.
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @return a printable name for the level ("scalar", "sse2", "avx2", "avx512").
+ */
+const char* simdLevelName(SimdLevel level);
+
+/**
+ * Forces the kernels used by ssdPlane8() to a specific level. Levels the build or CPU cannot run
+ * are clamped down to the best available one.
+ * @param[in] level the requested level.
+ * @return the level actually selected.
+ */
+SimdLevel setSimdLevel(SimdLevel level);
+
+/**
+ * @return the level currently used by ssdPlane8().
+ */
+SimdLevel currentSimdLevel();
+
+/**
+ * @param[in] level the requested level.
+ * @return the 8-bit plane kernel for the level, or nullptr if it is not compiled in.
+ */
+SsdPlane8Fn ssdPlane8Kernel(SimdLevel level);
+
+/**
+ * @param[in] level the requested level.
+ * @return the 16-bit plane kernel for the level, or nullptr if it is not compiled in.
+ */
+SsdPlane16Fn ssdPlane16Kernel(SimdLevel level);
+
+/**
+ * @param[in] level the requested level.
+ * @return the interleaved 8-bit kernel for the level, or nullptr if it is not compiled in.
+ */
+SsdInterleaved8Fn ssdInterleaved8Kernel(SimdLevel level);
+
+/**
+ * @param[in] level the requested level.
+ * @return the interleaved 16-bit kernel for the level, or nullptr if it is not compiled in.
+ */
+SsdInterleaved16Fn ssdInterleaved16Kernel(SimdLevel level);
+
+/**
+ * Sum of squared differences over a plane of 8-bit samples, using the kernel chosen by runtime
+ * CPU dispatch (see SsdPlane8Fn for parameters).
+ */
+uint64_t ssdPlane8(const uint8_t* ref, const uint8_t* tst, uint width, uint height, size_t stride);
+
+/**
+ * Sum of squared differences over a plane of 16-bit samples, using the kernel chosen by runtime
+ * CPU dispatch (see SsdPlane16Fn for parameters).
+ */
+uint64_t ssdPlane16(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                    size_t stride, uint bitDepth);
+
+/**
+ * Per-position sums of squared differences over a surface of interleaved 8-bit samples, using the
+ * kernel chosen by runtime CPU dispatch (see SsdInterleaved8Fn for parameters).
+ */
+void ssdInterleaved8(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                     size_t stride, uint64_t* sums);
+
+/**
+ * Per-position sums of squared differences over a surface of interleaved 16-bit words, using the
+ * kernel chosen by runtime CPU dispatch (see SsdInterleaved16Fn for parameters).
+ */
+void ssdInterleaved16(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                      size_t stride, uint bitDepth, uint shift, uint64_t* sums);
+
+// Per-ISA implementations; each lives in its own translation unit built with matching flags.
+uint64_t ssdPlane8Scalar(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride);
+uint64_t ssdPlane16Scalar(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth);
+void ssdInterleaved8Scalar(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                           size_t stride, uint64_t* sums);
+void ssdInterleaved16Scalar(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                            size_t stride, uint bitDepth, uint shift, uint64_t* sums);
+#ifdef VIDEOINFO_X86
+uint64_t ssdPlane8SSE2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                       size_t stride);
+uint64_t ssdPlane8AVX2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                       size_t stride);
+uint64_t ssdPlane8AVX512(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride);
+uint64_t ssdPlane16SSE2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                        size_t stride, uint bitDepth);
+uint64_t ssdPlane16AVX2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                        size_t stride, uint bitDepth);
+uint64_t ssdPlane16AVX512(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth);
+void ssdInterleaved8SSE2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride, uint64_t* sums);
+void ssdInterleaved8AVX2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride, uint64_t* sums);
+void ssdInterleaved8AVX512(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                           size_t stride, uint64_t* sums);
+void ssdInterleaved16SSE2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth, uint shift, uint64_t* sums);
+void ssdInterleaved16AVX2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth, uint shift, uint64_t* sums);
+void ssdInterleaved16AVX512(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                            size_t stride, uint bitDepth, uint shift, uint64_t* sums);
+#endif
+
+/**
+ * Number of madd iterations a 32-bit accumulator lane can absorb before it may wrap, when every
+ * iteration adds a pair of squared errors of bitDepth-bit samples (at most 2 * (2^bitDepth - 1)^2).
+ * @param[in] bitDepth significant bits per sample, at most 15.
+ * @return the flush interval in iterations.
+ */
+inline uint32_t ssdFlushInterval(uint bitDepth) {
+    uint64_t maxSample = (1u << bitDepth) - 1;
+    return (uint32_t) (UINT32_MAX / (2 * maxSample * maxSample));
+}
+
+#endif // VIDEOINFO_SSD_H
@@ -0,0 +1,223 @@
+#include "ssd.h"
+
+#include <immintrin.h>
+
+namespace {
+
+// Sums eight unsigned 32-bit lanes into a 64-bit scalar.
+inline uint64_t sumLanes(__m256i acc) {
+    __m256i wide = _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(acc)),
+                                    _mm256_cvtepu32_epi64(_mm256_extracti128_si256(acc, 1)));
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(wide), _mm256_extracti128_si256(wide, 1));
+    return (uint64_t) (_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+}
+
+} // namespace
+
+uint64_t ssdPlane8AVX2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                       size_t stride) {
+    const __m256i zero = _mm256_setzero_si256();
+    // Two vpmaddwd results land in each lane per iteration.
+    const uint32_t flushInterval = ssdFlushInterval(8) / 2;
+    uint32_t pending = 0;
+    __m256i acc = zero;
+    uint64_t sum = 0;
+
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        uint x = 0;
+
+        // 32 samples per iteration: zero-extend each 16-byte half to 16 bits, subtract, then
+        // vpmaddwd squares and sums adjacent pairs into 32-bit lanes. The lanes carry across rows
+        // and are only flushed into the 64-bit total when they could next wrap.
+        for (; x + 32 <= width; x += 32) {
+            __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (rRow + x)));
+            __m256i t0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (tRow + x)));
+            __m256i r1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (rRow + x + 16)));
+            __m256i t1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (tRow + x + 16)));
+            __m256i d0 = _mm256_sub_epi16(r0, t0);
+            __m256i d1 = _mm256_sub_epi16(r1, t1);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d0, d0));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d1, d1));
+            if (++pending == flushInterval) {
+                sum += sumLanes(acc);
+                acc = zero;
+                pending = 0;
+            }
+        }
+
+        for (; x < width; ++x) {
+            int d = rRow[x] - tRow[x];
+            sum += d * d;
+        }
+    }
+    return sum + sumLanes(acc);
+}
+
+uint64_t ssdPlane16AVX2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                        size_t stride, uint bitDepth) {
+    const __m256i zero = _mm256_setzero_si256();
+    const uint32_t mask = (1u << bitDepth) - 1;
+    const __m256i vmask = _mm256_set1_epi16((short) mask);
+    uint64_t sum = 0;
+
+    if (bitDepth <= 15) {
+        // Differences fit int16, so vpmaddwd squares and pair-sums them into 32-bit lanes, which
+        // are flushed to 64 bits before they can wrap.
+        const uint32_t flushInterval = ssdFlushInterval(bitDepth);
+        uint32_t pending = 0;
+        __m256i acc = zero;
+        for (uint y = 0; y < height; ++y) {
+            const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+            const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+            uint x = 0;
+            for (; x + 16 <= width; x += 16) {
+                __m256i r = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (rRow + x)), vmask);
+                __m256i t = _mm256_and_si256(_mm256_loadu_si256((const __m256i*) (tRow + x)), vmask);
+                __m256i d = _mm256_sub_epi16(r, t);
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+                if (++pending == flushInterval) {
+                    sum += sumLanes(acc);
+                    acc = zero;
+                    pending = 0;
+                }
+            }
+            for (; x < width; ++x) {
+                int64_t d = (int64_t) (rRow[x] & mask) - (tRow[x] & mask);
+                sum += d * d;
+            }
+        }
+        return sum + sumLanes(acc);
+    }
+
+    // Full 16-bit samples: differences need 17 bits, so square the absolute difference with a
+    // 16x16->32 multiply and accumulate straight into 64-bit lanes.
+    __m256i acc = zero;
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        uint x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m256i r = _mm256_loadu_si256((const __m256i*) (rRow + x));
+            __m256i t = _mm256_loadu_si256((const __m256i*) (tRow + x));
+            __m256i ad = _mm256_or_si256(_mm256_subs_epu16(r, t), _mm256_subs_epu16(t, r));
+            __m256i lo = _mm256_mullo_epi16(ad, ad);
+            __m256i hi = _mm256_mulhi_epu16(ad, ad);
+            __m256i sq0 = _mm256_unpacklo_epi16(lo, hi);
+            __m256i sq1 = _mm256_unpackhi_epi16(lo, hi);
+            acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(sq0, zero));
+            acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(sq0, zero));
+            acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(sq1, zero));
+            acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(sq1, zero));
+        }
+        for (; x < width; ++x) {
+            int64_t d = (int64_t) rRow[x] - tRow[x];
+            sum += d * d;
+        }
+    }
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return sum + (uint64_t) (_mm_cvtsi128_si64(half) + _mm_extract_epi64(half, 1));
+}
+
+void ssdInterleaved8AVX2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride, uint64_t* sums) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i evenWords = _mm256_set1_epi32(0xFFFF);
+    const __m256i evenLanes = _mm256_set1_epi64x(0xFFFFFFFFll);
+    const uint32_t flushInterval = ssdFlushInterval(8) / 2;
+    uint32_t pending = 0;
+    // vpmaddwd pairs samples 4k, 4k+1 into even lanes and 4k+2, 4k+3 into odd lanes: `all` sums
+    // both of each pair, `first` only 4k (even lanes) and 4k+2 (odd lanes). Positions 1 and 3 are
+    // the difference.
+    __m256i all = zero, first = zero;
+    uint64_t s[4] = { 0, 0, 0, 0 };
+
+    auto flush = [&]() {
+        uint64_t allEven = sumLanes(_mm256_and_si256(all, evenLanes));
+        uint64_t firstEven = sumLanes(_mm256_and_si256(first, evenLanes));
+        uint64_t firstOdd = sumLanes(first) - firstEven;
+        s[0] += firstEven;
+        s[1] += allEven - firstEven;
+        s[2] += firstOdd;
+        s[3] += sumLanes(all) - allEven - firstOdd;
+        all = first = zero;
+        pending = 0;
+    };
+
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        uint x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m256i r0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (rRow + x)));
+            __m256i t0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (tRow + x)));
+            __m256i r1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (rRow + x + 16)));
+            __m256i t1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (tRow + x + 16)));
+            __m256i d0 = _mm256_sub_epi16(r0, t0);
+            __m256i d1 = _mm256_sub_epi16(r1, t1);
+            all = _mm256_add_epi32(all, _mm256_madd_epi16(d0, d0));
+            all = _mm256_add_epi32(all, _mm256_madd_epi16(d1, d1));
+            first = _mm256_add_epi32(first,
+                                     _mm256_madd_epi16(d0, _mm256_and_si256(d0, evenWords)));
+            first = _mm256_add_epi32(first,
+                                     _mm256_madd_epi16(d1, _mm256_and_si256(d1, evenWords)));
+            if (++pending == flushInterval) {
+                flush();
+            }
+        }
+        for (; x < width; ++x) {
+            int d = rRow[x] - tRow[x];
+            s[x & 3] += d * d;
+        }
+    }
+    flush();
+    for (int c = 0; c < 4; c++) {
+        sums[c] = s[c];
+    }
+}
+
+void ssdInterleaved16AVX2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth, uint shift, uint64_t* sums) {
+    const __m256i zero = _mm256_setzero_si256();
+    const uint32_t mask = (1u << bitDepth) - 1;
+    const __m256i vmask = _mm256_set1_epi16((short) mask);
+    const __m128i count = _mm_cvtsi32_si128((int) shift);
+    const __m256i evenWords = _mm256_set1_epi32(0xFFFF);
+    const uint32_t flushInterval = ssdFlushInterval(bitDepth);
+    uint32_t pending = 0;
+    // vpmaddwd pairs samples 2k and 2k+1 into one lane: `all` sums both, `first` only 2k.
+    __m256i all = zero, first = zero;
+    uint64_t s[2] = { 0, 0 };
+
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        uint x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m256i r = _mm256_and_si256(
+                    _mm256_srl_epi16(_mm256_loadu_si256((const __m256i*) (rRow + x)), count),
+                    vmask);
+            __m256i t = _mm256_and_si256(
+                    _mm256_srl_epi16(_mm256_loadu_si256((const __m256i*) (tRow + x)), count),
+                    vmask);
+            __m256i d = _mm256_sub_epi16(r, t);
+            all = _mm256_add_epi32(all, _mm256_madd_epi16(d, d));
+            first = _mm256_add_epi32(first, _mm256_madd_epi16(d, _mm256_and_si256(d, evenWords)));
+            if (++pending == flushInterval) {
+                uint64_t f = sumLanes(first);
+                s[0] += f;
+                s[1] += sumLanes(all) - f;
+                all = first = zero;
+                pending = 0;
+            }
+        }
+        for (; x < width; ++x) {
+            int64_t d = (int64_t) ((rRow[x] >> shift) & mask) - ((tRow[x] >> shift) & mask);
+            s[x & 1] += d * d;
+        }
+    }
+    uint64_t f = sumLanes(first);
+    sums[0] = s[0] + f;
+    sums[1] = s[1] + sumLanes(all) - f;
+}
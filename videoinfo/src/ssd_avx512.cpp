@@ -0,0 +1,213 @@
+#include "ssd.h"
+
+#include <immintrin.h>
+
+namespace {
+
+// Sums sixteen unsigned 32-bit lanes into a 64-bit scalar.
+inline uint64_t sumLanes(__m512i acc) {
+    __m512i wide = _mm512_add_epi64(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(acc)),
+                                    _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(acc, 1)));
+    return (uint64_t) _mm512_reduce_add_epi64(wide);
+}
+
+} // namespace
+
+uint64_t ssdPlane8AVX512(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride) {
+    const __m512i zero = _mm512_setzero_si512();
+    // Up to two vpmaddwd results land in each lane per iteration.
+    const uint32_t flushInterval = ssdFlushInterval(8) / 2;
+    uint32_t pending = 0;
+    __m512i acc = zero;
+    uint64_t sum = 0;
+
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+
+        // 64 samples per iteration: zero-extend each 32-byte half to 16 bits, subtract, then
+        // vpmaddwd squares and sums adjacent pairs into 32-bit lanes. The row tail uses masked
+        // loads, so masked-off samples compare as zero. The lanes carry across rows and are only
+        // flushed into the 64-bit total when they could next wrap.
+        for (uint x = 0; x < width; x += 64) {
+            uint remaining = width - x;
+            __mmask32 m0 = (remaining >= 32) ? (__mmask32) ~0u
+                                             : (__mmask32) ((1u << remaining) - 1);
+            __mmask32 m1 = (remaining >= 64) ? (__mmask32) ~0u
+                         : (remaining > 32)  ? (__mmask32) ((1u << (remaining - 32)) - 1)
+                                             : (__mmask32) 0;
+            __m512i r0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m0, rRow + x));
+            __m512i t0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m0, tRow + x));
+            __m512i r1 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m1, rRow + x + 32));
+            __m512i t1 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m1, tRow + x + 32));
+            __m512i d0 = _mm512_sub_epi16(r0, t0);
+            __m512i d1 = _mm512_sub_epi16(r1, t1);
+            acc = _mm512_add_epi32(acc, _mm512_madd_epi16(d0, d0));
+            acc = _mm512_add_epi32(acc, _mm512_madd_epi16(d1, d1));
+            if (++pending == flushInterval) {
+                sum += sumLanes(acc);
+                acc = zero;
+                pending = 0;
+            }
+        }
+    }
+    return sum + sumLanes(acc);
+}
+
+uint64_t ssdPlane16AVX512(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth) {
+    const __m512i zero = _mm512_setzero_si512();
+    const uint32_t mask = (1u << bitDepth) - 1;
+    const __m512i vmask = _mm512_set1_epi16((short) mask);
+    uint64_t sum = 0;
+
+    if (bitDepth <= 15) {
+        // Differences fit int16, so vpmaddwd squares and pair-sums them into 32-bit lanes, which
+        // are flushed to 64 bits before they can wrap. Row tails use masked loads.
+        const uint32_t flushInterval = ssdFlushInterval(bitDepth);
+        uint32_t pending = 0;
+        __m512i acc = zero;
+        for (uint y = 0; y < height; ++y) {
+            const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+            const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+            for (uint x = 0; x < width; x += 32) {
+                uint remaining = width - x;
+                __mmask32 m = (remaining >= 32) ? (__mmask32) ~0u
+                                                : (__mmask32) ((1u << remaining) - 1);
+                __m512i r = _mm512_and_si512(_mm512_maskz_loadu_epi16(m, rRow + x), vmask);
+                __m512i t = _mm512_and_si512(_mm512_maskz_loadu_epi16(m, tRow + x), vmask);
+                __m512i d = _mm512_sub_epi16(r, t);
+                acc = _mm512_add_epi32(acc, _mm512_madd_epi16(d, d));
+                if (++pending == flushInterval) {
+                    sum += sumLanes(acc);
+                    acc = zero;
+                    pending = 0;
+                }
+            }
+        }
+        return sum + sumLanes(acc);
+    }
+
+    // Full 16-bit samples: differences need 17 bits, so square the absolute difference with a
+    // 16x16->32 multiply and accumulate straight into 64-bit lanes.
+    __m512i acc = zero;
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        for (uint x = 0; x < width; x += 32) {
+            uint remaining = width - x;
+            __mmask32 m = (remaining >= 32) ? (__mmask32) ~0u : (__mmask32) ((1u << remaining) - 1);
+            __m512i r = _mm512_maskz_loadu_epi16(m, rRow + x);
+            __m512i t = _mm512_maskz_loadu_epi16(m, tRow + x);
+            __m512i ad = _mm512_or_si512(_mm512_subs_epu16(r, t), _mm512_subs_epu16(t, r));
+            __m512i lo = _mm512_mullo_epi16(ad, ad);
+            __m512i hi = _mm512_mulhi_epu16(ad, ad);
+            __m512i sq0 = _mm512_unpacklo_epi16(lo, hi);
+            __m512i sq1 = _mm512_unpackhi_epi16(lo, hi);
+            acc = _mm512_add_epi64(acc, _mm512_unpacklo_epi32(sq0, zero));
+            acc = _mm512_add_epi64(acc, _mm512_unpackhi_epi32(sq0, zero));
+            acc = _mm512_add_epi64(acc, _mm512_unpacklo_epi32(sq1, zero));
+            acc = _mm512_add_epi64(acc, _mm512_unpackhi_epi32(sq1, zero));
+        }
+    }
+    return sum + (uint64_t) _mm512_reduce_add_epi64(acc);
+}
+
+void ssdInterleaved8AVX512(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                           size_t stride, uint64_t* sums) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i evenWords = _mm512_set1_epi32(0xFFFF);
+    const __m512i evenLanes = _mm512_set1_epi64(0xFFFFFFFFll);
+    const uint32_t flushInterval = ssdFlushInterval(8) / 2;
+    uint32_t pending = 0;
+    // vpmaddwd pairs samples 4k, 4k+1 into even lanes and 4k+2, 4k+3 into odd lanes: `all` sums
+    // both of each pair, `first` only 4k (even lanes) and 4k+2 (odd lanes). Positions 1 and 3 are
+    // the difference. Masked-off tail samples compare as zero.
+    __m512i all = zero, first = zero;
+    uint64_t s[4] = { 0, 0, 0, 0 };
+
+    auto flush = [&]() {
+        uint64_t allEven = sumLanes(_mm512_and_si512(all, evenLanes));
+        uint64_t firstEven = sumLanes(_mm512_and_si512(first, evenLanes));
+        uint64_t firstOdd = sumLanes(first) - firstEven;
+        s[0] += firstEven;
+        s[1] += allEven - firstEven;
+        s[2] += firstOdd;
+        s[3] += sumLanes(all) - allEven - firstOdd;
+        all = first = zero;
+        pending = 0;
+    };
+
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        for (uint x = 0; x < width; x += 64) {
+            uint remaining = width - x;
+            __mmask32 m0 = (remaining >= 32) ? (__mmask32) ~0u
+                                             : (__mmask32) ((1u << remaining) - 1);
+            __mmask32 m1 = (remaining >= 64) ? (__mmask32) ~0u
+                         : (remaining > 32)  ? (__mmask32) ((1u << (remaining - 32)) - 1)
+                                             : (__mmask32) 0;
+            __m512i r0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m0, rRow + x));
+            __m512i t0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m0, tRow + x));
+            __m512i r1 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m1, rRow + x + 32));
+            __m512i t1 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m1, tRow + x + 32));
+            __m512i d0 = _mm512_sub_epi16(r0, t0);
+            __m512i d1 = _mm512_sub_epi16(r1, t1);
+            all = _mm512_add_epi32(all, _mm512_madd_epi16(d0, d0));
+            all = _mm512_add_epi32(all, _mm512_madd_epi16(d1, d1));
+            first = _mm512_add_epi32(first,
+                                     _mm512_madd_epi16(d0, _mm512_and_si512(d0, evenWords)));
+            first = _mm512_add_epi32(first,
+                                     _mm512_madd_epi16(d1, _mm512_and_si512(d1, evenWords)));
+            if (++pending == flushInterval) {
+                flush();
+            }
+        }
+    }
+    flush();
+    for (int c = 0; c < 4; c++) {
+        sums[c] = s[c];
+    }
+}
+
+void ssdInterleaved16AVX512(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                            size_t stride, uint bitDepth, uint shift, uint64_t* sums) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i vmask = _mm512_set1_epi16((short) ((1u << bitDepth) - 1));
+    const __m128i count = _mm_cvtsi32_si128((int) shift);
+    const __m512i evenWords = _mm512_set1_epi32(0xFFFF);
+    const uint32_t flushInterval = ssdFlushInterval(bitDepth);
+    uint32_t pending = 0;
+    // vpmaddwd pairs samples 2k and 2k+1 into one lane: `all` sums both, `first` only 2k.
+    __m512i all = zero, first = zero;
+    uint64_t s[2] = { 0, 0 };
+
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        for (uint x = 0; x < width; x += 32) {
+            uint remaining = width - x;
+            __mmask32 m = (remaining >= 32) ? (__mmask32) ~0u
+                                            : (__mmask32) ((1u << remaining) - 1);
+            __m512i r = _mm512_and_si512(
+                    _mm512_srl_epi16(_mm512_maskz_loadu_epi16(m, rRow + x), count), vmask);
+            __m512i t = _mm512_and_si512(
+                    _mm512_srl_epi16(_mm512_maskz_loadu_epi16(m, tRow + x), count), vmask);
+            __m512i d = _mm512_sub_epi16(r, t);
+            all = _mm512_add_epi32(all, _mm512_madd_epi16(d, d));
+            first = _mm512_add_epi32(first, _mm512_madd_epi16(d, _mm512_and_si512(d, evenWords)));
+            if (++pending == flushInterval) {
+                uint64_t f = sumLanes(first);
+                s[0] += f;
+                s[1] += sumLanes(all) - f;
+                all = first = zero;
+                pending = 0;
+            }
+        }
+    }
+    uint64_t f = sumLanes(first);
+    sums[0] = s[0] + f;
+    sums[1] = s[1] + sumLanes(all) - f;
+}
@@ -0,0 +1,216 @@
+#include "ssd.h"
+
+#include <emmintrin.h>
+
+namespace {
+
+// Sums four unsigned 32-bit lanes into a 64-bit scalar.
+inline uint64_t sumLanes(__m128i acc) {
+    const __m128i zero = _mm_setzero_si128();
+    acc = _mm_add_epi64(_mm_unpacklo_epi32(acc, zero), _mm_unpackhi_epi32(acc, zero));
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi64(acc, acc));
+    return (uint64_t) _mm_cvtsi128_si64(acc);
+}
+
+} // namespace
+
+uint64_t ssdPlane8SSE2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                       size_t stride) {
+    const __m128i zero = _mm_setzero_si128();
+    // Two pmaddwd results land in each lane per iteration.
+    const uint32_t flushInterval = ssdFlushInterval(8) / 2;
+    uint32_t pending = 0;
+    __m128i acc = zero;
+    uint64_t sum = 0;
+
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        uint x = 0;
+
+        // 16 samples per iteration: widen to 16 bits, subtract, then pmaddwd squares and sums
+        // adjacent pairs into 32-bit lanes. The lanes carry across rows and are only flushed into
+        // the 64-bit total when they could next wrap.
+        for (; x + 16 <= width; x += 16) {
+            __m128i r = _mm_loadu_si128((const __m128i*) (rRow + x));
+            __m128i t = _mm_loadu_si128((const __m128i*) (tRow + x));
+            __m128i dLo = _mm_sub_epi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(t, zero));
+            __m128i dHi = _mm_sub_epi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(t, zero));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(dLo, dLo));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(dHi, dHi));
+            if (++pending == flushInterval) {
+                sum += sumLanes(acc);
+                acc = zero;
+                pending = 0;
+            }
+        }
+
+        for (; x < width; ++x) {
+            int d = rRow[x] - tRow[x];
+            sum += d * d;
+        }
+    }
+    return sum + sumLanes(acc);
+}
+
+uint64_t ssdPlane16SSE2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                        size_t stride, uint bitDepth) {
+    const __m128i zero = _mm_setzero_si128();
+    const uint32_t mask = (1u << bitDepth) - 1;
+    const __m128i vmask = _mm_set1_epi16((short) mask);
+    uint64_t sum = 0;
+
+    if (bitDepth <= 15) {
+        // Differences fit int16, so pmaddwd squares and pair-sums them into 32-bit lanes. The
+        // lanes are flushed to 64 bits before they can wrap: every 128 vectors at 12 bits,
+        // every 2052 at 10 bits.
+        const uint32_t flushInterval = ssdFlushInterval(bitDepth);
+        uint32_t pending = 0;
+        __m128i acc = zero;
+        for (uint y = 0; y < height; ++y) {
+            const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+            const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+            uint x = 0;
+            for (; x + 8 <= width; x += 8) {
+                __m128i r = _mm_and_si128(_mm_loadu_si128((const __m128i*) (rRow + x)), vmask);
+                __m128i t = _mm_and_si128(_mm_loadu_si128((const __m128i*) (tRow + x)), vmask);
+                __m128i d = _mm_sub_epi16(r, t);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(d, d));
+                if (++pending == flushInterval) {
+                    sum += sumLanes(acc);
+                    acc = zero;
+                    pending = 0;
+                }
+            }
+            for (; x < width; ++x) {
+                int64_t d = (int64_t) (rRow[x] & mask) - (tRow[x] & mask);
+                sum += d * d;
+            }
+        }
+        return sum + sumLanes(acc);
+    }
+
+    // Full 16-bit samples: differences need 17 bits, so square the absolute difference with a
+    // 16x16->32 multiply and accumulate straight into 64-bit lanes.
+    __m128i acc = zero;
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        uint x = 0;
+        for (; x + 8 <= width; x += 8) {
+            __m128i r = _mm_loadu_si128((const __m128i*) (rRow + x));
+            __m128i t = _mm_loadu_si128((const __m128i*) (tRow + x));
+            __m128i ad = _mm_or_si128(_mm_subs_epu16(r, t), _mm_subs_epu16(t, r));
+            __m128i lo = _mm_mullo_epi16(ad, ad);
+            __m128i hi = _mm_mulhi_epu16(ad, ad);
+            __m128i sq0 = _mm_unpacklo_epi16(lo, hi);
+            __m128i sq1 = _mm_unpackhi_epi16(lo, hi);
+            acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq0, zero));
+            acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq0, zero));
+            acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(sq1, zero));
+            acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(sq1, zero));
+        }
+        for (; x < width; ++x) {
+            int64_t d = (int64_t) rRow[x] - tRow[x];
+            sum += d * d;
+        }
+    }
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi64(acc, acc));
+    return sum + (uint64_t) _mm_cvtsi128_si64(acc);
+}
+
+void ssdInterleaved8SSE2(const uint8_t* ref, const uint8_t* tst, uint width, uint height,
+                         size_t stride, uint64_t* sums) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i evenWords = _mm_set1_epi32(0xFFFF);
+    const __m128i evenLanes = _mm_set_epi32(0, -1, 0, -1);
+    const uint32_t flushInterval = ssdFlushInterval(8) / 2;
+    uint32_t pending = 0;
+    // pmaddwd pairs samples 4k, 4k+1 into even lanes and 4k+2, 4k+3 into odd lanes: `all` sums
+    // both of each pair, `first` only 4k (even lanes) and 4k+2 (odd lanes). Positions 1 and 3 are
+    // the difference.
+    __m128i all = zero, first = zero;
+    uint64_t s[4] = { 0, 0, 0, 0 };
+
+    auto flush = [&]() {
+        uint64_t allEven = sumLanes(_mm_and_si128(all, evenLanes));
+        uint64_t firstEven = sumLanes(_mm_and_si128(first, evenLanes));
+        uint64_t firstOdd = sumLanes(first) - firstEven;
+        s[0] += firstEven;
+        s[1] += allEven - firstEven;
+        s[2] += firstOdd;
+        s[3] += sumLanes(all) - allEven - firstOdd;
+        all = first = zero;
+        pending = 0;
+    };
+
+    for (uint y = 0; y < height; ++y) {
+        const uint8_t* rRow = ref + y * stride;
+        const uint8_t* tRow = tst + y * stride;
+        uint x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i r = _mm_loadu_si128((const __m128i*) (rRow + x));
+            __m128i t = _mm_loadu_si128((const __m128i*) (tRow + x));
+            __m128i dLo = _mm_sub_epi16(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(t, zero));
+            __m128i dHi = _mm_sub_epi16(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(t, zero));
+            all = _mm_add_epi32(all, _mm_madd_epi16(dLo, dLo));
+            all = _mm_add_epi32(all, _mm_madd_epi16(dHi, dHi));
+            first = _mm_add_epi32(first, _mm_madd_epi16(dLo, _mm_and_si128(dLo, evenWords)));
+            first = _mm_add_epi32(first, _mm_madd_epi16(dHi, _mm_and_si128(dHi, evenWords)));
+            if (++pending == flushInterval) {
+                flush();
+            }
+        }
+        for (; x < width; ++x) {
+            int d = rRow[x] - tRow[x];
+            s[x & 3] += d * d;
+        }
+    }
+    flush();
+    for (int c = 0; c < 4; c++) {
+        sums[c] = s[c];
+    }
+}
+
+void ssdInterleaved16SSE2(const uint16_t* ref, const uint16_t* tst, uint width, uint height,
+                          size_t stride, uint bitDepth, uint shift, uint64_t* sums) {
+    const __m128i zero = _mm_setzero_si128();
+    const uint32_t mask = (1u << bitDepth) - 1;
+    const __m128i vmask = _mm_set1_epi16((short) mask);
+    const __m128i count = _mm_cvtsi32_si128((int) shift);
+    const __m128i evenWords = _mm_set1_epi32(0xFFFF);
+    const uint32_t flushInterval = ssdFlushInterval(bitDepth);
+    uint32_t pending = 0;
+    // pmaddwd pairs samples 2k and 2k+1 into one lane: `all` sums both, `first` only 2k.
+    __m128i all = zero, first = zero;
+    uint64_t s[2] = { 0, 0 };
+
+    for (uint y = 0; y < height; ++y) {
+        const uint16_t* rRow = (const uint16_t*) ((const uint8_t*) ref + y * stride);
+        const uint16_t* tRow = (const uint16_t*) ((const uint8_t*) tst + y * stride);
+        uint x = 0;
+        for (; x + 8 <= width; x += 8) {
+            __m128i r = _mm_and_si128(
+                    _mm_srl_epi16(_mm_loadu_si128((const __m128i*) (rRow + x)), count), vmask);
+            __m128i t = _mm_and_si128(
+                    _mm_srl_epi16(_mm_loadu_si128((const __m128i*) (tRow + x)), count), vmask);
+            __m128i d = _mm_sub_epi16(r, t);
+            all = _mm_add_epi32(all, _mm_madd_epi16(d, d));
+            first = _mm_add_epi32(first, _mm_madd_epi16(d, _mm_and_si128(d, evenWords)));
+            if (++pending == flushInterval) {
+                uint64_t f = sumLanes(first);
+                s[0] += f;
+                s[1] += sumLanes(all) - f;
+                all = first = zero;
+                pending = 0;
+            }
+        }
+        for (; x < width; ++x) {
+            int64_t d = (int64_t) ((rRow[x] >> shift) & mask) - ((tRow[x] >> shift) & mask);
+            s[x & 1] += d * d;
+        }
+    }
+    uint64_t f = sumLanes(first);
+    sums[0] = s[0] + f;
+    sums[1] = s[1] + sumLanes(all) - f;
+}
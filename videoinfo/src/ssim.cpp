@@ -0,0 +1,286 @@
+#include "ssim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const uint BLOCK = 4;                   // block edge; windows are 2x2 blocks
+const uint WINDOW = 2 * BLOCK;          // window edge
+const uint MAX_SCALES = 5;
+const double MSSSIM_WEIGHTS[MAX_SCALES] = { 0.0448, 0.2856, 0.3001, 0.2363, 0.1333 };
+const double K1 = 0.01, K2 = 0.03;
+
+/**
+ * Accumulator wide enough for the sums of squares of one window: 32 bits hold 8x8 windows of
+ * 8-bit samples, 16-bit samples need 64.
+ */
+template <class T> struct Accumulator;
+template <> struct Accumulator<uint8_t> { typedef uint32_t type; };
+template <> struct Accumulator<uint16_t> { typedef uint64_t type; };
+
+/**
+ * Mean SSIM terms over all windows of one plane at one scale.
+ */
+struct WindowMeans {
+    double ssim;  // mean of l * cs
+    double l;     // mean luminance term
+    double cs;    // mean contrast-structure term
+};
+
+/**
+ * SSIM terms of one window from its sums, with the stabilizing constants scaled by n^2 so the
+ * means and variances never have to be divided out.
+ */
+inline void windowTerms(double s1, double s2, double ss, double s12, double n, double c1,
+                        double c2, double* l, double* cs) {
+    double vars = n * ss - s1 * s1 - s2 * s2;
+    double covar = n * s12 - s1 * s2;
+    c1 *= n * n;
+    c2 *= n * n;
+    *l = (2 * s1 * s2 + c1) / (s1 * s1 + s2 * s2 + c1);
+    *cs = (2 * covar + c2) / (vars + c2);
+}
+
+/**
+ * Sums of reference, test, squares (both) and cross products over a run of samples.
+ */
+template <class A>
+struct Sums {
+    vector<A> s1, s2, ss, s12;
+
+    void resize(size_t n) {
+        s1.assign(n, 0);
+        s2.assign(n, 0);
+        ss.assign(n, 0);
+        s12.assign(n, 0);
+    }
+};
+
+template <class T>
+WindowMeans windowMeans(const T* ref, const T* tst, uint width, uint height, size_t stride,
+                        uint32_t mask, double c1, double c2) {
+    typedef typename Accumulator<T>::type A;
+    WindowMeans result = { 0, 0, 0 };
+
+    if (width < WINDOW || height < WINDOW) {
+        // Too small for a single window: score the whole plane as one.
+        double s1 = 0, s2 = 0, ss = 0, s12 = 0;
+        for (uint y = 0; y < height; y++) {
+            const T* r = (const T*) ((const uint8_t*) ref + y * stride);
+            const T* t = (const T*) ((const uint8_t*) tst + y * stride);
+            for (uint x = 0; x < width; x++) {
+                double a = r[x] & mask, b = t[x] & mask;
+                s1 += a;
+                s2 += b;
+                ss += a * a + b * b;
+                s12 += a * b;
+            }
+        }
+        windowTerms(s1, s2, ss, s12, (double) width * height, c1, c2, &result.l, &result.cs);
+        result.ssim = result.l * result.cs;
+        return result;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // OPTIMIZATION:
+    //
+    // The window sums are separable. Each strip of BLOCK rows is first summed down the columns in
+    // one pass over the four rows, then across groups of BLOCK columns into block sums. A window is
+    // the sum of 2x2 neighbouring blocks, so only the previous strip's block sums are kept and every
+    // sample is loaded exactly once. The SSIM terms of a strip's windows are computed into arrays
+    // with no loop-carried dependency so the divisions vectorize, and summed afterwards.
+    //----------------------------------------------------------------------------------------------
+    uint blocksX = width / BLOCK, blocksY = height / BLOCK;
+    uint columns = blocksX * BLOCK;
+    uint windowsX = blocksX - 1;
+
+    thread_local Sums<A> column;
+    thread_local Sums<A> blocks[2];
+    thread_local vector<double> lTerms, csTerms;
+    column.resize(columns);
+    blocks[0].resize(blocksX);
+    blocks[1].resize(blocksX);
+    lTerms.resize(windowsX);
+    csTerms.resize(windowsX);
+
+    A* c1s = column.s1.data();
+    A* c2s = column.s2.data();
+    A* css = column.ss.data();
+    A* c12s = column.s12.data();
+    double* lw = lTerms.data();
+    double* csw = csTerms.data();
+    const double n = WINDOW * WINDOW;
+    const double C1 = c1 * n * n, C2 = c2 * n * n;
+
+    double sumSSIM = 0, sumL = 0, sumCS = 0;
+    for (uint by = 0; by < blocksY; by++) {
+        const T* r[BLOCK];
+        const T* t[BLOCK];
+        for (uint i = 0; i < BLOCK; i++) {
+            r[i] = (const T*) ((const uint8_t*) ref + (by * BLOCK + i) * stride);
+            t[i] = (const T*) ((const uint8_t*) tst + (by * BLOCK + i) * stride);
+        }
+        for (uint x = 0; x < columns; x++) {
+            A a0 = r[0][x] & mask, a1 = r[1][x] & mask, a2 = r[2][x] & mask, a3 = r[3][x] & mask;
+            A b0 = t[0][x] & mask, b1 = t[1][x] & mask, b2 = t[2][x] & mask, b3 = t[3][x] & mask;
+            c1s[x] = a0 + a1 + a2 + a3;
+            c2s[x] = b0 + b1 + b2 + b3;
+            css[x] = a0 * a0 + a1 * a1 + a2 * a2 + a3 * a3 + b0 * b0 + b1 * b1 + b2 * b2 + b3 * b3;
+            c12s[x] = a0 * b0 + a1 * b1 + a2 * b2 + a3 * b3;
+        }
+
+        Sums<A>& cur = blocks[by & 1];
+        A* b1s = cur.s1.data();
+        A* b2s = cur.s2.data();
+        A* bss = cur.ss.data();
+        A* b12s = cur.s12.data();
+        for (uint bx = 0; bx < blocksX; bx++) {
+            uint x = bx * BLOCK;
+            b1s[bx] = c1s[x] + c1s[x + 1] + c1s[x + 2] + c1s[x + 3];
+            b2s[bx] = c2s[x] + c2s[x + 1] + c2s[x + 2] + c2s[x + 3];
+            bss[bx] = css[x] + css[x + 1] + css[x + 2] + css[x + 3];
+            b12s[bx] = c12s[x] + c12s[x + 1] + c12s[x + 2] + c12s[x + 3];
+        }
+
+        if (by == 0) {
+            continue;
+        }
+        const Sums<A>& prev = blocks[(by - 1) & 1];
+        const A* p1s = prev.s1.data();
+        const A* p2s = prev.s2.data();
+        const A* pss = prev.ss.data();
+        const A* p12s = prev.s12.data();
+        for (uint bx = 0; bx < windowsX; bx++) {
+            double s1 = (double) (p1s[bx] + p1s[bx + 1] + b1s[bx] + b1s[bx + 1]);
+            double s2 = (double) (p2s[bx] + p2s[bx + 1] + b2s[bx] + b2s[bx + 1]);
+            double ss = (double) (pss[bx] + pss[bx + 1] + bss[bx] + bss[bx + 1]);
+            double s12 = (double) (p12s[bx] + p12s[bx + 1] + b12s[bx] + b12s[bx + 1]);
+            double vars = n * ss - s1 * s1 - s2 * s2;
+            double covar = n * s12 - s1 * s2;
+            lw[bx] = (2 * s1 * s2 + C1) / (s1 * s1 + s2 * s2 + C1);
+            csw[bx] = (2 * covar + C2) / (vars + C2);
+        }
+        for (uint bx = 0; bx < windowsX; bx++) {
+            sumSSIM += lw[bx] * csw[bx];
+            sumL += lw[bx];
+            sumCS += csw[bx];
+        }
+    }
+
+    double windows = (double) (blocksX - 1) * (blocksY - 1);
+    result.ssim = sumSSIM / windows;
+    result.l = sumL / windows;
+    result.cs = sumCS / windows;
+    return result;
+}
+
+/**
+ * Halves a plane in both directions by averaging 2x2 neighbourhoods.
+ */
+template <class T>
+void downsample(const T* src, uint width, uint height, size_t stride, uint32_t mask,
+                vector<T>* dst) {
+    uint w = width / 2, h = height / 2;
+    dst->resize((size_t) w * h);
+    for (uint y = 0; y < h; y++) {
+        const T* r0 = (const T*) ((const uint8_t*) src + 2 * y * stride);
+        const T* r1 = (const T*) ((const uint8_t*) src + (2 * y + 1) * stride);
+        T* out = dst->data() + (size_t) y * w;
+        for (uint x = 0; x < w; x++) {
+            uint32_t sum = (r0[2 * x] & mask) + (r0[2 * x + 1] & mask) + (r1[2 * x] & mask) +
+                           (r1[2 * x + 1] & mask);
+            out[x] = (T) ((sum + 2) >> 2);
+        }
+    }
+}
+
+template <class T>
+void planeSSIM(const T* ref, const T* tst, uint width, uint height, size_t stride, uint bitDepth,
+               unsigned metrics, double* ssim, double* msssim) {
+    const uint32_t mask = (1u << bitDepth) - 1;
+    double peak = (double) ((1u << bitDepth) - 1);
+    double c1 = (K1 * peak) * (K1 * peak);
+    double c2 = (K2 * peak) * (K2 * peak);
+
+    WindowMeans full = windowMeans(ref, tst, width, height, stride, mask, c1, c2);
+    if (metrics & METRIC_SSIM) {
+        *ssim = full.ssim;
+    }
+    if (!(metrics & METRIC_MSSSIM)) {
+        return;
+    }
+
+    uint scales = 1;
+    while (scales < MAX_SCALES && std::min(width, height) >> scales >= WINDOW) {
+        scales++;
+    }
+    double weightSum = 0;
+    for (uint s = 0; s < scales; s++) {
+        weightSum += MSSSIM_WEIGHTS[s];
+    }
+
+    // Ping-pong scratch planes per thread: level s is written to levels[s & 1] while level s - 1 is
+    // read from the other pair.
+    thread_local vector<T> levels[2][2];
+    const T* r = ref;
+    const T* t = tst;
+    WindowMeans m = full;
+    double result = 1;
+    for (uint s = 0;; s++) {
+        double w = MSSSIM_WEIGHTS[s] / weightSum;
+        if (s + 1 == scales) {
+            result *= pow(m.l, w) * pow(std::max(m.cs, 0.0), w);
+            break;
+        }
+        // Negative mean contrast-structure (anti-correlated content) is clamped so pow() stays real.
+        result *= pow(std::max(m.cs, 0.0), w);
+
+        vector<T>* out = levels[s & 1];
+        downsample(r, width, height, stride, mask, &out[0]);
+        downsample(t, width, height, stride, mask, &out[1]);
+        width /= 2;
+        height /= 2;
+        stride = width * sizeof(T);
+        r = out[0].data();
+        t = out[1].data();
+        m = windowMeans(r, t, width, height, stride, mask, c1, c2);
+    }
+    *msssim = result;
+}
+
+} // namespace
+
+bool parseMetrics(const string& list, unsigned* metrics) {
+    *metrics = 0;
+    istringstream iss(list);
+    string name;
+    while (getline(iss, name, ',')) {
+        if (name == "psnr") {
+            *metrics |= METRIC_PSNR;
+        } else if (name == "ssim") {
+            *metrics |= METRIC_SSIM;
+        } else if (name == "msssim") {
+            *metrics |= METRIC_MSSSIM;
+        } else {
+            return false;
+        }
+    }
+    return *metrics != 0;
+}
+
+void planeSSIM(const FrameGeometry& g, int p, const uint8_t* ref, const uint8_t* tst,
+               unsigned metrics, double* ssim, double* msssim) {
+    const PlaneGeometry& pg = g.planes[p];
+    if (g.bytesPerSample == 1) {
+        planeSSIM(ref + pg.offset, tst + pg.offset, pg.width, pg.height, pg.stride, g.bitDepth,
+                  metrics, ssim, msssim);
+    } else {
+        planeSSIM((const uint16_t*) (ref + pg.offset), (const uint16_t*) (tst + pg.offset),
+                  pg.width, pg.height, pg.stride, g.bitDepth, metrics, ssim, msssim);
+    }
+}
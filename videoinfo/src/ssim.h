@@ -0,0 +1,79 @@
+#ifndef VIDEOINFO_SSIM_H
+#define VIDEOINFO_SSIM_H
+
+#include <cstdint>
+#include <string>
+
+#include "frame_geometry.h"
+
+/**
+ * Quality metrics selectable with --metrics; combined as a bit mask.
+ */
+enum Metric { METRIC_PSNR = 1 << 0, METRIC_SSIM = 1 << 1, METRIC_MSSSIM = 1 << 2 };
+
+/**
+ * Parses a comma-separated --metrics list such as "psnr,ssim,msssim".
+ * @param[in] list the metric names.
+ * @param[out] metrics the selected metrics as a Metric mask.
+ * @return false if the list is empty or names an unknown metric.
+ */
+bool parseMetrics(const std::string& list, unsigned* metrics);
+
+/**
+ * Per-plane structural similarity of one frame. Fields for metrics that were not requested are 0.
+ */
+typedef struct FrameSSIM {
+    double ssim[NUM_PLANES];
+    double msssim[NUM_PLANES];
+} FrameSSIM;
+
+/**
+ * Computes mean SSIM and/or MS-SSIM of one plane.
+ *
+ * Statistics are gathered over 8x8 windows stepped by 4 samples, as in x264 and ffmpeg: sums of
+ * 4x4 blocks are formed once and every window adds four of them. MS-SSIM repeats this over up to
+ * five dyadic scales (fewer when the plane gets smaller than a window) with the weights of Wang et
+ * al., renormalized over the scales used.
+ *
+ * @param[in] g the frame layout.
+ * @param[in] p the plane.
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tst first byte of the test frame.
+ * @param[in] metrics METRIC_SSIM and/or METRIC_MSSSIM.
+ * @param[out] ssim mean SSIM of the plane; written if METRIC_SSIM is set.
+ * @param[out] msssim MS-SSIM of the plane; written if METRIC_MSSSIM is set.
+ */
+void planeSSIM(const FrameGeometry& g, int p, const uint8_t* ref, const uint8_t* tst,
+               unsigned metrics, double* ssim, double* msssim);
+
+/**
+ * Computes the requested structural similarity metrics for every plane of a frame.
+ * @param[in] g the frame layout.
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tst first byte of the test frame.
+ * @param[in] metrics METRIC_SSIM and/or METRIC_MSSSIM.
+ * @return the per-plane results.
+ */
+inline FrameSSIM frameSSIM(const FrameGeometry& g, const uint8_t* ref, const uint8_t* tst,
+                           unsigned metrics) {
+    FrameSSIM result = {{0, 0, 0}, {0, 0, 0}};
+    for (int p = 0; p < NUM_PLANES; p++) {
+        planeSSIM(g, p, ref, tst, metrics, &result.ssim[p], &result.msssim[p]);
+    }
+    return result;
+}
+
+/**
+ * Aggregates per-plane values into a frame value: their average, as for PSNR.
+ * @param[in] planes one value per plane.
+ * @return the frame value.
+ */
+inline double planeAverage(const double* planes) {
+    double sum = 0;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        sum += planes[p];
+    }
+    return sum / NUM_PLANES;
+}
+
+#endif // VIDEOINFO_SSIM_H
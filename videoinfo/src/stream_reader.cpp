@@ -0,0 +1,175 @@
+#include "stream_reader.h"
+
+#include <algorithm>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "videoinfo_error.h"
+
+using namespace std;
+
+namespace {
+
+// Linux pipes default to 64 KiB, which costs a context switch with the producer every few rows of
+// an HD frame. Ask for more; unprivileged users may be capped lower, which is fine.
+const int PIPE_BYTES = 1 << 20;
+
+// Skipped frames are drained through a small stack buffer.
+const size_t SKIP_CHUNK_BYTES = 64 << 10;
+
+} // namespace
+
+StreamFrameSource::StreamFrameSource(const string& path, size_t bytesPerFrame, unsigned buffers,
+                                     const FrameSampling& sampling)
+        : path_(path), fd_(-1), bytesPerFrame_(bytesPerFrame), sampling_(sampling),
+          end_(UNKNOWN_FRAMES), stop_(false) {
+    fd_ = (path == "-") ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        throw VideoInfoError("failed to open file: " + path);
+    }
+#ifdef F_SETPIPE_SZ
+    fcntl(fd_, F_SETPIPE_SZ, PIPE_BYTES);
+#endif
+
+    slots_.resize(buffers ? buffers : 1);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        slots_[i].buffer.resize(bytesPerFrame_);
+        slots_[i].frame = EMPTY;
+        slots_[i].next = i;
+        slots_[i].ready = false;
+    }
+
+    reader_ = thread(&StreamFrameSource::readerLoop, this);
+}
+
+StreamFrameSource::~StreamFrameSource() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    slotFree_.notify_all();
+    reader_.join();
+    if (fd_ != STDIN_FILENO) {
+        close(fd_);
+    }
+}
+
+bool StreamFrameSource::isStream(const string& path) {
+    struct stat st;
+    return path == "-" || (stat(path.c_str(), &st) == 0 && !S_ISREG(st.st_mode));
+}
+
+const uint8_t* StreamFrameSource::acquire(size_t f) {
+    Slot& slot = slots_[f % slots_.size()];
+    unique_lock<mutex> lock(mutex_);
+    frameReady_.wait(lock, [this, &slot, f] {
+        return (slot.frame == f && slot.ready) || f >= end_ || !error_.empty();
+    });
+    if (slot.frame == f && slot.ready) {
+        return slot.buffer.data();
+    }
+    if (f >= end_) {
+        return nullptr;
+    }
+    throw VideoInfoError(error_);
+}
+
+void StreamFrameSource::release(size_t f) {
+    Slot& slot = slots_[f % slots_.size()];
+    {
+        lock_guard<mutex> lock(mutex_);
+        slot.frame = EMPTY;
+        slot.ready = false;
+        slot.next = f + slots_.size();
+    }
+    slotFree_.notify_all();
+}
+
+void StreamFrameSource::readerLoop() {
+    for (size_t f = 0;; f++) {
+        Slot& slot = slots_[f % slots_.size()];
+        {
+            // Wait for the consumer to hand back the frame that used this slot one lap earlier.
+            unique_lock<mutex> lock(mutex_);
+            slotFree_.wait(lock, [this, &slot, f] { return stop_ || slot.next == f; });
+            if (stop_) {
+                return;
+            }
+            slot.frame = f;
+        }
+
+        // Frames the sampling leaves out still have to be consumed from a pipe.
+        size_t gap = (f == 0) ? sampling_.first : sampling_.step - 1;
+        bool complete;
+        try {
+            complete = skip(gap * bytesPerFrame_) && readFrame(f, slot);
+        } catch (const VideoInfoError& e) {
+            // Consumers waiting for any frame wake up and rethrow.
+            {
+                lock_guard<mutex> lock(mutex_);
+                error_ = e.what();
+            }
+            frameReady_.notify_all();
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (complete) {
+                slot.ready = true;
+            } else {
+                // A trailing partial frame is dropped, as it is for regular files.
+                slot.frame = EMPTY;
+                end_ = f;
+            }
+        }
+        frameReady_.notify_all();
+        if (!complete) {
+            return;
+        }
+    }
+}
+
+bool StreamFrameSource::skip(size_t bytes) {
+    if (bytes == 0 || lseek(fd_, bytes, SEEK_CUR) >= 0) {
+        return true;
+    }
+    char scratch[SKIP_CHUNK_BYTES];
+    while (bytes > 0) {
+        ssize_t n = read(fd_, scratch, std::min(bytes, sizeof(scratch)));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            throw VideoInfoError("failed to read from stream: " + path_);
+        }
+        if (n == 0) {
+            return false;
+        }
+        bytes -= n;
+    }
+    return true;
+}
+
+bool StreamFrameSource::readFrame(size_t f, Slot& slot) {
+    size_t got = 0;
+    while (got < bytesPerFrame_) {
+        ssize_t n = read(fd_, slot.buffer.data() + got, bytesPerFrame_ - got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            throw VideoInfoError("failed to read frame " + to_string(f) + " from stream: " +
+                                 path_);
+        }
+        if (n == 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef VIDEOINFO_STREAM_READER_H
+#define VIDEOINFO_STREAM_READER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_source.h"
+
+/**
+ * Frames read sequentially from a pipe, FIFO or stdin, e.g. straight from an ffmpeg decode.
+ *
+ * The length of a stream is unknown until it ends, so frameCount() is UNKNOWN_FRAMES and acquire()
+ * returns nullptr for frames past the end. One reader thread fills a bounded ring of buffers in
+ * frame order, the same way PrefetchFrameSource does: frame f lives in slot f % buffers and a slot
+ * is only refilled once the frame that previously occupied it has been released. Decoding upstream
+ * and scoring here therefore run concurrently, with at most `buffers` frames in memory.
+ */
+class StreamFrameSource : public FrameSource {
+public:
+    /**
+     * Opens the stream and starts the reader thread. Throws VideoInfoError on failure.
+     * @param[in] path the pipe or FIFO to read, or "-" for stdin.
+     * @param[in] bytesPerFrame size of one frame.
+     * @param[in] buffers number of frame buffers in the ring.
+     * @param[in] sampling the frames to serve; frames in between are read and discarded.
+     */
+    StreamFrameSource(const std::string& path, size_t bytesPerFrame, unsigned buffers,
+                      const FrameSampling& sampling = FrameSampling());
+    ~StreamFrameSource() override;
+
+    size_t frameCount() const override { return UNKNOWN_FRAMES; }
+    size_t maxHeldFrames() const override { return slots_.size(); }
+    const uint8_t* acquire(size_t f) override;
+    void release(size_t f) override;
+
+    /**
+     * @param[in] path a path given on the command line.
+     * @return true if the path is "-" or names something other than a regular file, i.e. it can
+     *         only be read front to back.
+     */
+    static bool isStream(const std::string& path);
+
+private:
+    struct Slot {
+        std::vector<uint8_t> buffer;
+        size_t frame;         // frame currently held, or EMPTY
+        size_t next;          // the only frame allowed to claim the slot next
+        bool ready;           // frame has been read and may be acquired
+    };
+
+    static const size_t EMPTY = ~(size_t) 0;
+
+    void readerLoop();
+    bool readFrame(size_t f, Slot& slot);
+    bool skip(size_t bytes);
+
+    std::string path_;
+    int fd_;
+    size_t bytesPerFrame_;
+    FrameSampling sampling_;
+    size_t end_;              // number of complete frames in the stream, UNKNOWN_FRAMES until EOF
+
+    std::vector<Slot> slots_;
+    std::thread reader_;
+
+    std::mutex mutex_;
+    std::condition_variable slotFree_;
+    std::condition_variable frameReady_;
+    std::string error_;       // why a read failed, empty while all reads succeed
+    bool stop_;
+};
+
+#endif // VIDEOINFO_STREAM_READER_H
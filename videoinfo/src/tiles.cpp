@@ -0,0 +1,66 @@
+#include "tiles.h"
+
+#include <algorithm>
+
+#include "psnr.h"
+
+using namespace std;
+
+TileGrid TileGrid::make(const FrameGeometry& g, uint tileWidth, uint tileHeight) {
+    const PlaneGeometry& py = g.planes[PLANE_Y];
+    TileGrid grid;
+    grid.tileWidth = std::min(tileWidth, py.width);
+    grid.tileHeight = std::min(tileHeight, py.height);
+    grid.columns = (py.width + grid.tileWidth - 1) / grid.tileWidth;
+    grid.rows = (py.height + grid.tileHeight - 1) / grid.tileHeight;
+    return grid;
+}
+
+PlaneRect TileGrid::rect(const FrameGeometry& g, int p, uint column, uint row) const {
+    const PlaneGeometry& pg = g.planes[p];
+    uint xShift = (p == PLANE_Y) ? 0 : g.chromaShiftX;
+    uint yShift = (p == PLANE_Y) ? 0 : g.chromaShiftY;
+    PlaneRect r;
+    r.x = (column * tileWidth) >> xShift;
+    r.y = (row * tileHeight) >> yShift;
+    r.width = (column + 1 == columns) ? pg.width - r.x : tileWidth >> xShift;
+    r.height = (row + 1 == rows) ? pg.height - r.y : tileHeight >> yShift;
+    return r;
+}
+
+void tileSSE(const FrameGeometry& g, const TileGrid& grid, const uint8_t* ref,
+             const uint8_t* const* tsts, size_t count, uint64_t* sse) {
+    //----------------------------------------------------------------------------------------------
+    // OPTIMIZATION:
+    //
+    // Tiles are scored with the same SIMD plane kernel as whole frames, one call per tile with the
+    // frame stride, so each tile's rows stream contiguously into its own bucket. A row of tiles is
+    // a band of the plane a few hundred KiB at most; every test is scored against the band while
+    // the reference band is still in cache, as frameSSE() does for whole planes.
+    //----------------------------------------------------------------------------------------------
+    size_t perTest = grid.count() * NUM_PLANES;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        const PlaneGeometry& pg = g.planes[p];
+        for (uint ty = 0; ty < grid.rows; ty++) {
+            for (size_t i = 0; i < count; i++) {
+                if (!tsts[i]) {
+                    continue;
+                }
+                for (uint tx = 0; tx < grid.columns; tx++) {
+                    PlaneRect r = grid.rect(g, p, tx, ty);
+                    size_t offset = pg.offset + r.y * pg.stride + (size_t) r.x * g.bytesPerSample;
+                    uint64_t e;
+                    if (g.bytesPerSample == 1) {
+                        e = ssdPlane8(ref + offset, tsts[i] + offset, r.width, r.height,
+                                      pg.stride);
+                    } else {
+                        e = ssdPlane16((const uint16_t*) (ref + offset),
+                                       (const uint16_t*) (tsts[i] + offset), r.width, r.height,
+                                       pg.stride, g.bitDepth);
+                    }
+                    sse[i * perTest + ((size_t) ty * grid.columns + tx) * NUM_PLANES + p] = e;
+                }
+            }
+        }
+    }
+}
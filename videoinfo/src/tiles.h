@@ -0,0 +1,59 @@
+#ifndef VIDEOINFO_TILES_H
+#define VIDEOINFO_TILES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frame_geometry.h"
+
+/**
+ * Rectangle of samples within one plane.
+ */
+typedef struct PlaneRect {
+    uint x, y;
+    uint width, height;
+} PlaneRect;
+
+/**
+ * Division of a frame into a grid of equally sized tiles, counted in luma samples. When the frame
+ * is not a whole number of tiles the last column and row are cut short, so the grid covers every
+ * sample exactly once. Tile sizes are multiples of the chroma decimation, so chroma tiles are the
+ * same grid scaled down.
+ */
+typedef struct TileGrid {
+    uint tileWidth, tileHeight;  // luma samples per tile
+    uint columns, rows;          // tiles across and down
+
+    /**
+     * @param[in] g the frame layout being tiled.
+     * @param[in] tileWidth tile width in luma samples.
+     * @param[in] tileHeight tile height in luma samples.
+     * @return the grid.
+     */
+    static TileGrid make(const FrameGeometry& g, uint tileWidth, uint tileHeight);
+
+    size_t count() const { return (size_t) columns * rows; }
+
+    /**
+     * @param[in] g the frame layout being tiled.
+     * @param[in] p the plane.
+     * @param[in] column the tile column.
+     * @param[in] row the tile row.
+     * @return the samples of plane p covered by the tile.
+     */
+    PlaneRect rect(const FrameGeometry& g, int p, uint column, uint row) const;
+} TileGrid;
+
+/**
+ * Per-tile, per-plane sum of squared errors of one reference frame against several test frames.
+ * @param[in] g the frame layout.
+ * @param[in] grid the tile grid.
+ * @param[in] ref first byte of the reference frame.
+ * @param[in] tsts first byte of each test frame; nullptr entries are skipped.
+ * @param[in] count number of test frames.
+ * @param[out] sse grid.count() * NUM_PLANES values per test, tile-major in row order.
+ */
+void tileSSE(const FrameGeometry& g, const TileGrid& grid, const uint8_t* ref,
+             const uint8_t* const* tsts, size_t count, uint64_t* sse);
+
+#endif // VIDEOINFO_TILES_H
@@ -0,0 +1,171 @@
+#include "videoinfo.h"
+
+#include <regex>
+
+using namespace std;
+
+namespace {
+
+/**
+ * @param[in] xShift log2 of the horizontal chroma decimation.
+ * @param[in] yShift log2 of the vertical chroma decimation.
+ * @return frameSSE<S> for the matching subsampling scheme S, or nullptr if there is none.
+ */
+FrameSSE (*frameSSEKernel(uint xShift, uint yShift))(const FrameGeometry&, const uint8_t*,
+                                                       const uint8_t*) {
+    if (xShift == 0 && yShift == 0) {
+        return &frameSSE<YUV444>;
+    } else if (xShift == 1 && yShift == 0) {
+        return &frameSSE<YUV422>;
+    } else if (xShift == 1 && yShift == 1) {
+        return &frameSSE<YUV420>;
+    } else if (xShift == 2 && yShift == 0) {
+        return &frameSSE<YUV411>;
+    } else if (xShift == 0 && yShift == 1) {
+        return &frameSSE<YUV440>;
+    }
+    return nullptr;
+}
+
+/**
+ * @return the planar layout for the given chroma shifts.
+ */
+FrameGeometry planarGeometry(uint xShift, uint yShift, uint width, uint height, uint bitDepth) {
+    if (xShift == 0 && yShift == 0) {
+        return YUV444::geometry(width, height, bitDepth);
+    } else if (xShift == 1 && yShift == 0) {
+        return YUV422::geometry(width, height, bitDepth);
+    } else if (xShift == 1 && yShift == 1) {
+        return YUV420::geometry(width, height, bitDepth);
+    } else if (xShift == 2 && yShift == 0) {
+        return YUV411::geometry(width, height, bitDepth);
+    }
+    return YUV440::geometry(width, height, bitDepth);
+}
+
+} // namespace
+
+void resolveOptions(ScorerOptions* options, uint* xShift, uint* yShift) {
+    PixelFormat format = options->pixelFormat;
+    if (format != PIX_FMT_PLANAR) {
+        // Interleaved formats fix their subsampling; the sampling may only repeat it.
+        bool packed = (format == PIX_FMT_YUYV || format == PIX_FMT_UYVY);
+        string implied = packed ? "4:2:2" : "4:2:0";
+        if (!options->sampling.empty() && options->sampling != implied) {
+            throw VideoInfoError(string("pixel format ") + pixelFormatName(format) + " is " +
+                                 implied);
+        }
+        options->sampling = implied;
+    } else if (options->sampling.empty()) {
+        throw VideoInfoError("the subsampling is required for planar input");
+    }
+
+    if (!regex_match(options->sampling, regex("[0-9]:[0-9]:[0-9]"))) {
+        throw VideoInfoError("chroma subsampling parameter invalid format");
+    }
+    const string& s = options->sampling;
+    if (!chromaShifts((uint8_t) (s[0] - '0'), (uint8_t) (s[2] - '0'), (uint8_t) (s[4] - '0'),
+                      xShift, yShift) ||
+            !frameSSEKernel(*xShift, *yShift)) {
+        throw VideoInfoError("unsupported sub-sampling mode; only 4:4:4, 4:2:2, 4:2:0, 4:1:1 "
+                             "and 4:4:0");
+    }
+
+    if (options->width == 0 || options->height == 0) {
+        throw VideoInfoError("width and height must be at least 1");
+    }
+    if (options->bitDepth < 8 || options->bitDepth > 16) {
+        throw VideoInfoError("bit depth must be between 8 and 16");
+    }
+    if (format == PIX_FMT_P010) {
+        if (options->bitDepth == 8) {
+            options->bitDepth = 10;
+        } else if (options->bitDepth != 10) {
+            throw VideoInfoError("pixel format p010 is 10-bit");
+        }
+    } else if (format != PIX_FMT_PLANAR && options->bitDepth != 8) {
+        throw VideoInfoError(string("pixel format ") + pixelFormatName(format) + " is 8-bit");
+    }
+    if ((format == PIX_FMT_YUYV || format == PIX_FMT_UYVY) && options->width % 2) {
+        throw VideoInfoError(string("pixel format ") + pixelFormatName(format) +
+                             " needs an even width");
+    }
+
+    unsigned known = METRIC_PSNR | METRIC_SSIM | METRIC_MSSSIM;
+    if (options->metrics == 0 || (options->metrics & ~known)) {
+        throw VideoInfoError("unknown metrics");
+    }
+    if (format != PIX_FMT_PLANAR && (options->metrics & (METRIC_SSIM | METRIC_MSSSIM))) {
+        throw VideoInfoError("ssim and msssim need planar input");
+    }
+#ifdef RGB888
+    if (options->bitDepth != 8) {
+        throw VideoInfoError("RGB888 builds only support 8-bit video");
+    }
+    if (format != PIX_FMT_PLANAR) {
+        throw VideoInfoError("RGB888 builds only support planar input");
+    }
+    if (options->metrics & (METRIC_SSIM | METRIC_MSSSIM)) {
+        throw VideoInfoError("RGB888 builds only support the psnr metric");
+    }
+#endif
+}
+
+Scorer::Scorer(const ScorerOptions& options) : sequence_(FrameGeometry()) {
+    ScorerOptions resolved = options;
+    uint xShift, yShift;
+    resolveOptions(&resolved, &xShift, &yShift);
+
+    g_ = planarGeometry(xShift, yShift, resolved.width, resolved.height, resolved.bitDepth);
+    if (resolved.pixelFormat != PIX_FMT_PLANAR) {
+        g_ = interleaveGeometry(g_, resolved.pixelFormat);
+    }
+    metrics_ = resolved.metrics;
+    frameSSE_ = frameSSEKernel(xShift, yShift);
+    sequence_ = SequenceScore(g_);
+}
+
+FrameScore Scorer::measure(const uint8_t* ref, const uint8_t* tst) const {
+    FrameScore s = {};
+    if (metrics_ & METRIC_PSNR) {
+        s.e = frameSSE_(g_, ref, tst);
+        for (int p = 0; p < NUM_PLANES; p++) {
+            s.mse[p] = planeMSE(g_, s.e, p);
+            s.psnr[p] = psnr(s.mse[p], g_.bitDepth);
+        }
+        s.score = frameScore(g_, s.e);
+    }
+    unsigned similarity = metrics_ & (METRIC_SSIM | METRIC_MSSSIM);
+    if (similarity) {
+        s.q = frameSSIM(g_, ref, tst, similarity);
+    }
+    return s;
+}
+
+FrameScore Scorer::score(const uint8_t* ref, const uint8_t* tst) {
+    FrameScore s = measure(ref, tst);
+    sequence_.add(s.e);
+    ssim_.add(planeAverage(s.q.ssim));
+    msssim_.add(planeAverage(s.q.msssim));
+    return s;
+}
+
+SequenceResult Scorer::sequence() const {
+    SequenceResult r = {};
+    r.frames = sequence_.frames();
+    if (r.frames == 0) {
+        return r;
+    }
+    if (metrics_ & METRIC_PSNR) {
+        r.psnr = sequence_.summarize();
+    }
+    r.ssim = ssim_.value() / r.frames;
+    r.msssim = msssim_.value() / r.frames;
+    return r;
+}
+
+void Scorer::reset() {
+    sequence_ = SequenceScore(g_);
+    ssim_ = KahanSum();
+    msssim_ = KahanSum();
+}
@@ -0,0 +1,121 @@
+#ifndef VIDEOINFO_VIDEOINFO_H
+#define VIDEOINFO_VIDEOINFO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "frame_geometry.h"
+#include "psnr.h"
+#include "sequence_score.h"
+#include "ssim.h"
+#include "videoinfo_error.h"
+
+/**
+ * Parameters of the video a Scorer compares. They mean the same as the command line options of
+ * the same name.
+ */
+typedef struct ScorerOptions {
+    uint width = 0;                          // luma width in samples
+    uint height = 0;                         // luma height in samples
+    std::string sampling;                    // "4:2:0" etc.; may be empty for interleaved formats
+    uint bitDepth = 8;                       // 8 to 16; P010 implies 10
+    PixelFormat pixelFormat = PIX_FMT_PLANAR;
+    unsigned metrics = METRIC_PSNR;          // Metric mask
+} ScorerOptions;
+
+/**
+ * Checks options and fills in what the pixel format implies: the subsampling of interleaved
+ * formats and the bit depth of P010.
+ * @param[in,out] options the video parameters.
+ * @param[out] xShift log2 of the horizontal chroma decimation.
+ * @param[out] yShift log2 of the vertical chroma decimation.
+ * @throws VideoInfoError if the options are invalid.
+ */
+void resolveOptions(ScorerOptions* options, uint* xShift, uint* yShift);
+
+/**
+ * Results for one frame. Fields of metrics that were not requested are 0.
+ */
+typedef struct FrameScore {
+    FrameSSE e;                  // per-plane sum of squared errors (METRIC_PSNR)
+    double mse[NUM_PLANES];      // per-plane mean squared error (METRIC_PSNR)
+    double psnr[NUM_PLANES];     // per-plane PSNR in dB (METRIC_PSNR)
+    double score;                // average of the per-plane PSNRs in dB (METRIC_PSNR)
+    FrameSSIM q;                 // per-plane SSIM and MS-SSIM (METRIC_SSIM, METRIC_MSSSIM)
+} FrameScore;
+
+/**
+ * Results for every frame scored so far. Fields of metrics that were not requested are 0.
+ */
+typedef struct SequenceResult {
+    size_t frames;               // frames scored
+    SequenceSummary psnr;        // sequence PSNR in every aggregation mode (METRIC_PSNR)
+    double ssim;                 // mean frame SSIM (METRIC_SSIM)
+    double msssim;               // mean frame MS-SSIM (METRIC_MSSSIM)
+} SequenceResult;
+
+/**
+ * Scores frames that are already in memory, for callers such as encoders that want quality
+ * numbers for frames as they produce them without writing raw video out first. This is the same
+ * engine the command line tool runs, with the same SIMD kernels and results.
+ *
+ * score() accumulates sequence results and must not be called concurrently on one Scorer; use one
+ * Scorer per stream. measure() only reads the Scorer and may be called from any number of threads.
+ */
+class Scorer {
+public:
+    /**
+     * Validates the options and prepares the frame layout.
+     * @param[in] options the video parameters.
+     * @throws VideoInfoError if the options are invalid.
+     */
+    explicit Scorer(const ScorerOptions& options);
+
+    /**
+     * @return the size in bytes of one raw frame, the amount score() reads from each buffer.
+     */
+    size_t frameBytes() const { return g_.bytesPerFrame; }
+
+    /**
+     * @return the frame layout scored.
+     */
+    const FrameGeometry& geometry() const { return g_; }
+
+    /**
+     * Scores one frame without adding it to the sequence.
+     * @param[in] ref the reference frame, frameBytes() long.
+     * @param[in] tst the test frame, frameBytes() long.
+     * @return the frame results.
+     */
+    FrameScore measure(const uint8_t* ref, const uint8_t* tst) const;
+
+    /**
+     * Scores the next frame of the sequence.
+     * @param[in] ref the reference frame, frameBytes() long.
+     * @param[in] tst the test frame, frameBytes() long.
+     * @return the frame results.
+     */
+    FrameScore score(const uint8_t* ref, const uint8_t* tst);
+
+    /**
+     * @return the results for the frames passed to score() since construction or reset().
+     */
+    SequenceResult sequence() const;
+
+    /**
+     * Starts a new sequence.
+     */
+    void reset();
+
+private:
+    typedef FrameSSE (*FrameSSEFn)(const FrameGeometry& g, const uint8_t* ref, const uint8_t* tst);
+
+    FrameGeometry g_;
+    unsigned metrics_;
+    FrameSSEFn frameSSE_;        // frameSSE<S> for the subsampling scheme
+    SequenceScore sequence_;
+    KahanSum ssim_, msssim_;
+};
+
+#endif // VIDEOINFO_VIDEOINFO_H
@@ -0,0 +1,123 @@
+#include "videoinfo_c.h"
+
+#include <algorithm>
+#include <string>
+
+#include "videoinfo.h"
+
+using namespace std;
+
+struct vi_scorer {
+    Scorer scorer;
+
+    explicit vi_scorer(const ScorerOptions& options) : scorer(options) {}
+};
+
+namespace {
+
+thread_local string t_lastError;
+
+vi_status fail(vi_status status, const string& message) {
+    t_lastError = message;
+    return status;
+}
+
+} // namespace
+
+void vi_options_init(vi_options* options) {
+    if (!options) {
+        return;
+    }
+    options->width = 0;
+    options->height = 0;
+    options->sampling = nullptr;
+    options->bit_depth = 8;
+    options->pix_fmt = nullptr;
+    options->metrics = VI_METRIC_PSNR;
+}
+
+vi_status vi_scorer_create(const vi_options* options, vi_scorer** scorer) {
+    if (!scorer) {
+        return fail(VI_ERROR_INVALID_ARGUMENT, "scorer is NULL");
+    }
+    *scorer = nullptr;
+    if (!options) {
+        return fail(VI_ERROR_INVALID_ARGUMENT, "options is NULL");
+    }
+
+    ScorerOptions o;
+    o.width = options->width;
+    o.height = options->height;
+    o.sampling = options->sampling ? options->sampling : "";
+    o.bitDepth = options->bit_depth;
+    o.metrics = options->metrics;
+    if (options->pix_fmt && !parsePixelFormat(options->pix_fmt, &o.pixelFormat)) {
+        return fail(VI_ERROR_INVALID_ARGUMENT, string("unknown pixel format: ") +
+                    options->pix_fmt);
+    }
+
+    try {
+        *scorer = new vi_scorer(o);
+    } catch (const VideoInfoError& e) {
+        return fail(VI_ERROR_INVALID_ARGUMENT, e.what());
+    } catch (const exception& e) {
+        return fail(VI_ERROR_INTERNAL, e.what());
+    }
+    t_lastError.clear();
+    return VI_OK;
+}
+
+void vi_scorer_destroy(vi_scorer* scorer) {
+    delete scorer;
+}
+
+size_t vi_scorer_frame_bytes(const vi_scorer* scorer) {
+    return scorer ? scorer->scorer.frameBytes() : 0;
+}
+
+vi_status vi_scorer_score(vi_scorer* scorer, const uint8_t* ref, const uint8_t* tst,
+                          vi_frame_score* score) {
+    if (!scorer || !ref || !tst) {
+        return fail(VI_ERROR_INVALID_ARGUMENT, "scorer and frames must not be NULL");
+    }
+    FrameScore s;
+    try {
+        s = scorer->scorer.score(ref, tst);
+    } catch (const exception& e) {
+        return fail(VI_ERROR_INTERNAL, e.what());
+    }
+    if (score) {
+        copy(s.e.sse, s.e.sse + NUM_PLANES, score->sse);
+        copy(s.mse, s.mse + NUM_PLANES, score->mse);
+        copy(s.psnr, s.psnr + NUM_PLANES, score->psnr);
+        score->score = s.score;
+        copy(s.q.ssim, s.q.ssim + NUM_PLANES, score->ssim);
+        copy(s.q.msssim, s.q.msssim + NUM_PLANES, score->msssim);
+    }
+    return VI_OK;
+}
+
+vi_status vi_scorer_sequence(const vi_scorer* scorer, vi_sequence_score* sequence) {
+    if (!scorer || !sequence) {
+        return fail(VI_ERROR_INVALID_ARGUMENT, "scorer and sequence must not be NULL");
+    }
+    SequenceResult r = scorer->scorer.sequence();
+    sequence->frames = r.frames;
+    sequence->mean = r.psnr.mean;
+    sequence->weighted = r.psnr.weighted;
+    copy(r.psnr.global, r.psnr.global + NUM_PLANES, sequence->global);
+    sequence->global_all = r.psnr.globalAll;
+    sequence->ssim = r.ssim;
+    sequence->msssim = r.msssim;
+    return VI_OK;
+}
+
+void vi_scorer_reset(vi_scorer* scorer) {
+    if (scorer) {
+        scorer->scorer.reset();
+    }
+}
+
+const char* vi_last_error(void) {
+    return t_lastError.c_str();
+}
@@ -0,0 +1,115 @@
+#ifndef VIDEOINFO_VIDEOINFO_C_H
+#define VIDEOINFO_VIDEOINFO_C_H
+
+/*
+ * C interface to libvideoinfo's Scorer (see videoinfo.h), for encoders and other callers that
+ * cannot use the C++ API. No function throws or exits; failures are reported as a vi_status and
+ * vi_last_error() describes the most recent one on the calling thread.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum vi_status {
+    VI_OK = 0,
+    VI_ERROR_INVALID_ARGUMENT = 1,   /* bad options, or a null pointer */
+    VI_ERROR_INTERNAL = 2            /* anything else, e.g. out of memory */
+} vi_status;
+
+/* Metric mask bits for vi_options.metrics. */
+#define VI_METRIC_PSNR   (1u << 0)
+#define VI_METRIC_SSIM   (1u << 1)
+#define VI_METRIC_MSSSIM (1u << 2)
+
+typedef struct vi_options {
+    unsigned width, height;          /* luma samples */
+    const char* sampling;            /* "4:2:0" etc.; may be NULL for interleaved formats */
+    unsigned bit_depth;              /* 8 to 16; p010 implies 10 */
+    const char* pix_fmt;             /* NULL or "planar", "nv12", "nv21", "p010", "yuyv", "uyvy" */
+    unsigned metrics;                /* VI_METRIC_* mask */
+} vi_options;
+
+typedef struct vi_frame_score {
+    uint64_t sse[3];                 /* per-plane sum of squared errors */
+    double mse[3];                   /* per-plane mean squared error */
+    double psnr[3];                  /* per-plane PSNR in dB */
+    double score;                    /* average of the per-plane PSNRs in dB */
+    double ssim[3];                  /* per-plane SSIM */
+    double msssim[3];                /* per-plane MS-SSIM */
+} vi_frame_score;
+
+typedef struct vi_sequence_score {
+    size_t frames;                   /* frames scored */
+    double mean;                     /* mean frame score in dB */
+    double weighted;                 /* mean 6:1:1 weighted frame score in dB */
+    double global[3];                /* per-plane PSNR of the MSE over all frames in dB */
+    double global_all;               /* PSNR of the MSE over all samples in dB */
+    double ssim;                     /* mean frame SSIM */
+    double msssim;                   /* mean frame MS-SSIM */
+} vi_sequence_score;
+
+typedef struct vi_scorer vi_scorer;
+
+/**
+ * Fills in the defaults: 8-bit planar video scored with PSNR. Width, height and sampling are left
+ * for the caller.
+ * @param[out] options the options to initialize.
+ */
+void vi_options_init(vi_options* options);
+
+/**
+ * @param[in] options the video parameters.
+ * @param[out] scorer the new scorer, to be freed with vi_scorer_destroy(); NULL on failure.
+ * @return VI_OK or the reason the scorer could not be created.
+ */
+vi_status vi_scorer_create(const vi_options* options, vi_scorer** scorer);
+
+/**
+ * @param[in] scorer the scorer, or NULL.
+ */
+void vi_scorer_destroy(vi_scorer* scorer);
+
+/**
+ * @param[in] scorer the scorer.
+ * @return the size in bytes of one raw frame.
+ */
+size_t vi_scorer_frame_bytes(const vi_scorer* scorer);
+
+/**
+ * Scores the next frame of the sequence. Must not be called concurrently on one scorer.
+ * @param[in] scorer the scorer.
+ * @param[in] ref the reference frame, vi_scorer_frame_bytes() long.
+ * @param[in] tst the test frame, vi_scorer_frame_bytes() long.
+ * @param[out] score the frame results; may be NULL.
+ * @return VI_OK or the reason the frame could not be scored.
+ */
+vi_status vi_scorer_score(vi_scorer* scorer, const uint8_t* ref, const uint8_t* tst,
+                          vi_frame_score* score);
+
+/**
+ * @param[in] scorer the scorer.
+ * @param[out] sequence the results for the frames scored since creation or the last reset.
+ * @return VI_OK or VI_ERROR_INVALID_ARGUMENT.
+ */
+vi_status vi_scorer_sequence(const vi_scorer* scorer, vi_sequence_score* sequence);
+
+/**
+ * Starts a new sequence.
+ * @param[in] scorer the scorer.
+ */
+void vi_scorer_reset(vi_scorer* scorer);
+
+/**
+ * @return a description of the last failure on the calling thread, or "" if there was none.
+ */
+const char* vi_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VIDEOINFO_VIDEOINFO_C_H */
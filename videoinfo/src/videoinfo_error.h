@@ -0,0 +1,16 @@
+#ifndef VIDEOINFO_ERROR_H
+#define VIDEOINFO_ERROR_H
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * Thrown by libvideoinfo for invalid parameters and for inputs that cannot be opened or read. The
+ * message is a complete sentence without the "ERROR: " prefix the command line tool adds.
+ */
+class VideoInfoError : public std::runtime_error {
+public:
+    explicit VideoInfoError(const std::string& message) : std::runtime_error(message) {}
+};
+
+#endif // VIDEOINFO_ERROR_H
@@ -0,0 +1,101 @@
+#include "worker_pool.h"
+
+using namespace std;
+
+namespace {
+
+thread_local unsigned t_threadIndex = 0;
+
+} // namespace
+
+WorkerPool::WorkerPool(unsigned threads)
+        : fn_(nullptr), count_(0), next_(0), active_(0), generation_(0), stop_(false) {
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    for (unsigned i = 1; i < threads; i++) {
+        workers_.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& w : workers_) {
+        w.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const function<void(size_t)>& fn) {
+    if (workers_.empty() || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        fn_ = &fn;
+        count_ = count;
+        next_ = 0;
+        active_ = workers_.size();
+        generation_++;
+    }
+    wake_.notify_all();
+
+    runTasks();
+
+    unique_lock<mutex> lock(mutex_);
+    done_.wait(lock, [this] { return active_ == 0; });
+    fn_ = nullptr;
+    if (error_) {
+        exception_ptr error = error_;
+        error_ = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+unsigned WorkerPool::threadIndex() {
+    return t_threadIndex;
+}
+
+void WorkerPool::workerLoop(unsigned index) {
+    t_threadIndex = index;
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(mutex_);
+            wake_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        runTasks();
+
+        lock_guard<mutex> lock(mutex_);
+        if (--active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runTasks() {
+    size_t i;
+    while ((i = next_.fetch_add(1)) < count_) {
+        try {
+            (*fn_)(i);
+        } catch (...) {
+            lock_guard<mutex> lock(mutex_);
+            if (!error_) {
+                error_ = current_exception();
+            }
+            next_ = count_;
+        }
+    }
+}
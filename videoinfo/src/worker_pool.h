@@ -0,0 +1,69 @@
+#ifndef VIDEOINFO_WORKER_POOL_H
+#define VIDEOINFO_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads that execute index-parallel loops.
+ *
+ * Threads are created once and parked between loops, so dispatching a batch of frames costs a
+ * wake-up rather than a thread spawn. The calling thread takes part in every loop.
+ */
+class WorkerPool {
+public:
+    /**
+     * @param[in] threads total number of threads, including the caller; 0 uses every core.
+     */
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @return the number of threads that run each loop, including the caller.
+     */
+    unsigned size() const { return workers_.size() + 1; }
+
+    /**
+     * Runs fn(i) for every i in [0, count) across the pool and returns once all calls finished.
+     * Indices are handed out dynamically, so the order of calls is unspecified. If a call throws,
+     * indices not yet started are skipped and the first exception is rethrown here.
+     * @param[in] count number of iterations.
+     * @param[in] fn the loop body.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    /**
+     * @return the index of the calling thread: 1 to size() - 1 for pool workers, 0 for any other
+     *         thread (including the one calling parallelFor()).
+     */
+    static unsigned threadIndex();
+
+private:
+    void workerLoop(unsigned index);
+    void runTasks();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const std::function<void(size_t)>* fn_;
+    size_t count_;
+    std::atomic<size_t> next_;
+    std::exception_ptr error_; // first exception thrown by the current loop
+    unsigned active_;      // workers that have not finished the current loop
+    uint64_t generation_;  // bumped for every loop so parked workers know there is new work
+    bool stop_;
+};
+
+#endif // VIDEOINFO_WORKER_POOL_H